@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <XEMarkup/MappingNode.h>
+#include <XEMarkup/JSONDocument.h>
+#include <XEMarkup/JSONFormatter.h>
+
+using namespace xe;
+
+using Clock = std::chrono::steady_clock;
+
+static double Milliseconds(const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// String-dominated corpus: 60,000 log records of 20-59 words, about 21 MB of JSON
+// with an escape (quote, backslash, newline or tab) roughly every 30 bytes.
+// The fixed seed makes every run produce the same document.
+static MappingNode GenerateLogCorpus(const size_t records = 60000, const uint32_t seed = 1)
+{
+    static const char* words[] =
+    {
+        "request", "handled", "in", "ms", "user", "session", "\"quoted\"", "path=C:\\\\temp\\\\file",
+        "caf\xC3\xA9", "line\nbreak", "error:", "timeout", "connection", "reset", "by", "peer", "tab\there"
+    };
+    constexpr size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    std::mt19937 random(seed);
+    MappingNode root;
+    MappingNode& logs = root["logs"];
+    for (size_t i = 0; i < records; ++i)
+    {
+        MappingNode record;
+        std::string message;
+        size_t length = 20 + random() % 40;
+        for (size_t k = 0; k < length; ++k)
+        {
+            if (k)
+                message += ' ';
+            message += words[random() % wordCount];
+        }
+        record["message"] = message;
+        record["level"] = (random() % 2) ? "info" : "warn";
+        logs.PushBack(record);
+    }
+    return root;
+}
+
+// Best of 'runs', which filters out most scheduler noise
+template<typename F>
+static double BestOf(const int runs, F&& body)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i)
+    {
+        Clock::time_point start = Clock::now();
+        body();
+        best = std::min(best, Milliseconds(start));
+    }
+    return best;
+}
+
+static void Report(const char* name, const double milliseconds, const size_t bytes)
+{
+    std::cout << name << ": " << milliseconds << " ms (" << bytes / milliseconds / 1e3 << " MB/s)\n";
+}
+
+// Usage: Benchmark [corpus.json]
+// Times JSON save, load and lazy reads over the generated corpus, and writes the
+// corpus to the given path so other tools can be measured against the same input.
+int main(int argc, char* argv[])
+{
+    constexpr int runs = 5;
+
+    MappingNode root = GenerateLogCorpus();
+    JSONFormatter formatter;
+    std::string content;
+    formatter.SaveContent(root, content);
+    std::cout << "corpus: " << root["logs"].Size() << " records, " << content.size() << " bytes\n";
+
+    if (argc > 1)
+    {
+        std::ofstream file(argv[1], std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!file)
+        {
+            std::cerr << "Could not write " << argv[1] << "\n";
+            return 1;
+        }
+    }
+
+    std::string saved;
+    Report("SaveContent", BestOf(runs, [&]()
+    {
+        saved.clear();
+        formatter.SaveContent(root, saved);
+    }), content.size());
+
+    Report("LoadContent", BestOf(runs, [&]()
+    {
+        MappingNode loaded = formatter.LoadContent(content);
+    }), content.size());
+
+    size_t total = 0;
+    Report("JSONDocument read all", BestOf(runs, [&]()
+    {
+        JSONDocument document(content);
+        for (JSONValue record : document["logs"])
+            total += record["message"].As<std::string>().size();
+    }), content.size());
+
+    // Keeps the reads from being optimized away
+    return (total == 0) ? 1 : 0;
+}
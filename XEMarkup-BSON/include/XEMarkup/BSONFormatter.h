@@ -33,11 +33,16 @@ namespace xe
 	{
 	public:
 		MappingNode LoadFile(const std::filesystem::path& path) override;
-		MappingNode LoadContent(const std::string& content) override { throw std::runtime_error("BSON is a binary-only format."); }
+		using IFormatter::LoadFile;
+		MappingNode LoadContent(const std::string& content) override { XE_THROW(std::runtime_error("BSON is a binary-only format.")); }
 		MappingNode LoadContent(const std::vector<uint8_t>& content) override;
+		MappingNode LoadContent(const uint8_t* data, size_t size) override;
+		using IFormatter::LoadContent;
+		using IFormatter::TryLoadContent;
+		ParseResult TryLoadContent(const uint8_t* data, size_t size) override;
 
 		bool SaveFile(const MappingNode& node, const std::filesystem::path& path) override;
-		void SaveContent(const MappingNode& node, std::string& out_content) { throw std::runtime_error("BSON is a binary-only format."); }
+		void SaveContent(const MappingNode& node, std::string& out_content) { XE_THROW(std::runtime_error("BSON is a binary-only format.")); }
 		void SaveContent(const MappingNode& node, std::vector<uint8_t>& out_content) override;
 
 		bool StringContent() const override { return false; };
@@ -24,167 +24,468 @@
 
 #include "XEMarkup/BSONFormatter.h"
 
-#include <nlohmann/json.hpp>
+#include <XEMarkup/FileIO.h>
+#include <XEMarkup/StringArena.h>
+#include <XEMarkup/Utf8.h>
 
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <limits>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace xe;
-using json = nlohmann::json;
 
-static void Import(const json& in, MappingNode& out)
+namespace
 {
-    if (in.is_object())
+enum : uint8_t
+{
+    Double = 0x01,
+    String = 0x02,
+    Document = 0x03,
+    Array = 0x04,
+    Binary = 0x05,
+    Boolean = 0x08,
+    Null = 0x0A,
+    Int32 = 0x10,
+    Int64 = 0x12,
+};
+
+// Builds nodes straight from the input, accepting the element types json::from_bson does, and
+// records the first error instead of throwing. With an arena, strings and binaries are views
+// into the input, which the arena must own; otherwise each is copied once into its node.
+class Reader
+{
+public:
+    Reader(const uint8_t* data, const size_t size, ParseError& error, std::shared_ptr<StringArena> arena)
+        : m_data(data), m_size(size), m_error(error), m_arena(std::move(arena))
     {
-        for (auto it = in.begin(); it != in.end(); ++it)
-        {
-            Import(it.value(), out[it.key()]);
-        }
-        return;
     }
 
-    if (in.is_array())
+    bool Run(MappingNode& out)
     {
-        for (const auto& child : in)
+        if (!ReadDocument(out, false))
+        {
+            out.Clear();
+            return false;
+        }
+        if (m_pos != m_size)
         {
-            MappingNode result;
-            Import(child, result);
-            out.PushBack(result);
+            out.Clear();
+            return Fail(ParseError::Code::Syntax, m_pos, "Unexpected bytes after the BSON document");
         }
-        return;
+        return true;
     }
 
-    if (in.is_boolean())
+private:
+    // Elements up to the terminating 0x00. Like from_bson, the length prefix is not trusted.
+    bool ReadDocument(MappingNode& out, const bool isArray)
     {
-        out = in.get<bool>();
-        return;
-    }
+        int32_t size = 0;
+        if (!Read(size))
+            return false;
 
-    if (in.is_number())
-    {
-        if (in.is_number_float())
+        while (true)
         {
-            if (in.is_number_float())
+            if (m_pos >= m_size)
+                return Truncated();
+            const uint8_t type = m_data[m_pos++];
+            if (type == 0)
+                return true;
+
+            const void* end = std::memchr(m_data + m_pos, 0, m_size - m_pos);
+            if (end == nullptr)
+                return Truncated();
+            const size_t keySize = static_cast<const uint8_t*>(end) - (m_data + m_pos);
+            const std::string key(reinterpret_cast<const char*>(m_data + m_pos), keySize);
+            m_pos += keySize + 1;
+
+            // Array keys are ignored; a repeated document key takes the last value
+            MappingNode* child;
+            if (isArray)
             {
-                out = in.get<float>();
-                return;
+                out.PushBack(MappingNode());
+                child = &out[out.Size() - 1];
             }
-            out = in.get<double>();
-            return;
-        }
-
-        if (!in.is_number_unsigned())
-        {
-            if (in.is_number_integer() && in.get<int64_t>() >= std::numeric_limits<int32_t>::min() &&
-                in.get<int64_t>() <= std::numeric_limits<int32_t>::max())
+            else
             {
-                out = in.get<int32_t>();
-                return;
+                child = &out[key];
+                child->Clear();
             }
-            out = in.get<int64_t>();
-            return;
+
+            if (!ReadValue(type, *child))
+                return false;
         }
+    }
 
-        if (in.is_number_unsigned() && in.get<uint64_t>() <= std::numeric_limits<uint32_t>::max())
+    bool ReadValue(const uint8_t type, MappingNode& out)
+    {
+        switch (type)
         {
-            out = in.get<uint32_t>();
-            return;
+        case Double:
+        {
+            double value = 0.0;
+            if (!Read(value))
+                return false;
+            out = value;
+            return true;
         }
-        out = in.get<uint64_t>();
-        return;
-    }
+        case String:
+        {
+            const size_t start = m_pos;
+            int32_t length = 0;
+            if (!Read(length))
+                return false;
+            if (length < 1)
+                return Fail(ParseError::Code::Syntax, start, "BSON string length must be at least 1, is " + std::to_string(length));
+            if (m_size - m_pos < static_cast<size_t>(length))
+                return Truncated();
 
-    out = in.get<std::string>();
-}
+            const std::string_view text(reinterpret_cast<const char*>(m_data + m_pos), static_cast<size_t>(length) - 1);
+            m_pos += static_cast<size_t>(length);
+            if (m_arena)
+                out.SetBorrowedString(StringArena::BorrowReferred(m_arena, text));
+            else
+                out = std::string(text);
+            return true;
+        }
+        case Document:
+        case Array:
+            return ReadDocument(out, type == Array);
+        case Binary:
+        {
+            const size_t start = m_pos;
+            int32_t length = 0;
+            if (!Read(length))
+                return false;
+            if (length < 0)
+                return Fail(ParseError::Code::Syntax, start, "BSON byte array length cannot be negative, is " + std::to_string(length));
+            if (m_size - m_pos < static_cast<size_t>(length) + 1)
+                return Truncated();
 
-static void Export(json& out, const MappingNode& in)
-{
-    if (in.IsMapping())
-    {
-        for (const MappingNode& child : in)
+            const uint8_t subtype = m_data[m_pos++];
+            const uint8_t* bytes = m_data + m_pos;
+            m_pos += static_cast<size_t>(length);
+            if (m_arena)
+                out.SetBorrowedBinary(StringArena::BorrowReferred(m_arena, std::string_view(reinterpret_cast<const char*>(bytes), length)), subtype);
+            else
+                out.SetBinary(bytes, static_cast<size_t>(length), subtype);
+            return true;
+        }
+        case Boolean:
+            if (m_pos >= m_size)
+                return Truncated();
+            out = (m_data[m_pos++] != 0);
+            return true;
+        case Null:
+            return true;
+        case Int32:
         {
-            json result;
-            Export(result, child);
-            out[child.Key()] = result;
+            int32_t value = 0;
+            if (!Read(value))
+                return false;
+            out = value;
+            return true;
+        }
+        case Int64:
+        {
+            int64_t value = 0;
+            if (!Read(value))
+                return false;
+            if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
+                out = static_cast<int32_t>(value);
+            else
+                out = value;
+            return true;
+        }
+        default:
+        {
+            static const char digits[] = "0123456789ABCDEF";
+            return Fail(ParseError::Code::Syntax, m_pos - 1, std::string("Unsupported BSON record type 0x") +
+                digits[type >> 4] + digits[type & 0xF]);
+        }
         }
-        return;
     }
 
-    if (in.IsArray())
+    // Little-endian, whatever the host
+    template<typename T>
+    bool Read(T& value)
     {
-        for (const MappingNode& child : in)
+        if (m_size - m_pos < sizeof(T))
+            return Truncated();
+
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+            bits |= static_cast<uint64_t>(m_data[m_pos + i]) << (8 * i);
+        m_pos += sizeof(T);
+
+        if constexpr (sizeof(T) == sizeof(uint32_t))
+        {
+            const uint32_t narrow = static_cast<uint32_t>(bits);
+            std::memcpy(&value, &narrow, sizeof(T));
+        }
+        else
         {
-            json result;
-            Export(result, child);
-            out.push_back(result);
+            std::memcpy(&value, &bits, sizeof(T));
         }
-        return;
+        return true;
     }
 
-    if (in.IsBoolean())
+    bool Truncated()
     {
-        out = in.As<bool>();
-        return;
+        return Fail(ParseError::Code::Syntax, m_size, "Unexpected end of BSON input");
     }
 
-    if (in.IsNumeric())
+    bool Fail(const ParseError::Code code, const size_t offset, std::string message)
+    {
+        m_error.code = code;
+        m_error.offset = offset;
+        m_error.message = std::move(message);
+        return false;
+    }
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos = 0;
+    ParseError& m_error;
+    std::shared_ptr<StringArena> m_arena;
+};
+
+// Writes the elements json::to_bson wrote for Export's json value, in the node's own key
+// order. Binary nodes become binary elements with their subtype.
+class Writer
+{
+public:
+    Writer(std::vector<uint8_t>& out, const bool checkUtf8) : m_out(out), m_checkUtf8(checkUtf8) {}
+
+    void Run(const MappingNode& node)
     {
-        if (in.HasDecimal())
+        if (node.IsDefined() && !node.IsMapping())
+            XE_THROW(std::runtime_error("BSON top level must be a mapping"));
+        WriteDocument(node);
+    }
+
+private:
+    void WriteDocument(const MappingNode& node)
+    {
+        const size_t start = m_out.size();
+        Write<int32_t>(0); // patched below
+
+        if (node.IsPacked())
         {
-            if (in.Width() == sizeof(float))
-            {
-                out = in.As<float>();
-                return;
-            }
-            out = in.As<double>();
+            const std::vector<double>& values = node.PackedValues();
+            for (size_t i = 0; i < values.size(); ++i)
+                WritePacked(std::to_string(i), values[i]);
+        }
+        else if (node.IsArray())
+        {
+            for (size_t i = 0; i < node.Size(); ++i)
+                WriteElement(std::to_string(i), node[i]);
+        }
+        else if (node.IsMapping())
+        {
+            for (const MappingNode& child : node)
+                WriteElement(child.Key(), child);
+        }
+        m_out.push_back(0);
+
+        const size_t size = m_out.size() - start;
+        if (size > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+            XE_THROW(std::runtime_error("BSON document exceeds 2 GiB"));
+        Patch(start, static_cast<int32_t>(size));
+    }
+
+    void WriteElement(const std::string_view key, const MappingNode& node)
+    {
+        // Export turns empty containers into null
+        if (!node.IsDefined() || ((node.IsMapping() || node.IsArray()) && node.Size() == 0))
+        {
+            WriteKey(Null, key);
+            return;
+        }
+
+        if (node.IsMapping() || node.IsArray())
+        {
+            WriteKey(node.IsMapping() ? Document : Array, key);
+            WriteDocument(node);
             return;
         }
 
-        if (in.IsNegative())
+        if (node.IsBoolean())
         {
-            if (in.Width() <= sizeof(int32_t))
+            WriteKey(Boolean, key);
+            m_out.push_back(node.As<bool>() ? 1 : 0);
+            return;
+        }
+
+        if (node.IsBinary())
+        {
+            const ByteSpan bytes = node.AsBytes();
+            if (bytes.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+                XE_THROW(std::runtime_error("BSON binary exceeds 2 GiB"));
+            WriteKey(Binary, key);
+            Write(static_cast<int32_t>(bytes.size()));
+            m_out.push_back(node.BinarySubtype());
+            m_out.insert(m_out.end(), bytes.begin(), bytes.end());
+            return;
+        }
+
+        if (node.IsNumeric())
+        {
+            if (node.HasDecimal())
             {
-                out = in.As<int32_t>();
-                return;
+                WriteKey(Double, key);
+                Write(node.As<double>());
             }
-            out = in.As<int64_t>();
+            else if (node.IsNegative())
+            {
+                WriteInteger(key, node.As<int64_t>());
+            }
+            else
+            {
+                const uint64_t value = node.As<uint64_t>();
+                if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+                    XE_THROW(std::runtime_error("Integer " + std::to_string(value) + " cannot be represented by BSON as it does not fit int64"));
+                WriteInteger(key, static_cast<int64_t>(value));
+            }
+            return;
+        }
+
+        const std::string_view text = node.AsStringView();
+        if (m_checkUtf8)
+            CheckUtf8(text);
+        if (text.size() >= static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+            XE_THROW(std::runtime_error("BSON string exceeds 2 GiB"));
+        WriteKey(String, key);
+        Write(static_cast<int32_t>(text.size() + 1));
+        m_out.insert(m_out.end(), text.begin(), text.end());
+        m_out.push_back(0);
+    }
+
+    // An element of a packed array, typed as the node it unpacks to
+    void WritePacked(const std::string_view key, const double value)
+    {
+        if (MappingNode::StoresAsInteger(value))
+        {
+            WriteInteger(key, static_cast<int64_t>(value));
             return;
         }
+        WriteKey(Double, key);
+        Write(value);
+    }
 
-        if (in.Width() <= sizeof(uint32_t))
+    void WriteInteger(const std::string_view key, const int64_t value)
+    {
+        if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
         {
-            out = in.As<uint32_t>();
+            WriteKey(Int32, key);
+            Write(static_cast<int32_t>(value));
             return;
         }
-        out = in.As<uint64_t>();
-        return;
+        WriteKey(Int64, key);
+        Write(value);
+    }
+
+    void WriteKey(const uint8_t type, const std::string_view key)
+    {
+        if (key.find('\0') != std::string_view::npos)
+            XE_THROW(std::runtime_error("BSON key cannot contain code point U+0000"));
+        if (m_checkUtf8)
+            CheckUtf8(key);
+
+        m_out.push_back(type);
+        m_out.insert(m_out.end(), key.begin(), key.end());
+        m_out.push_back(0);
+    }
+
+    // Little-endian, whatever the host
+    template<typename T>
+    void Write(const T value)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        for (size_t i = 0; i < sizeof(T); ++i)
+            m_out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+
+    void Patch(const size_t offset, const int32_t value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (size_t i = 0; i < sizeof(bits); ++i)
+            m_out[offset + i] = static_cast<uint8_t>(bits >> (8 * i));
     }
 
-    out = in.As<std::string>();
+    // BSON strings are UTF-8, but nothing else stops other bytes being written
+    static void CheckUtf8(const std::string_view text)
+    {
+        if (!Utf8::IsValid(text))
+            XE_THROW(std::runtime_error("Cannot save a string that is not valid UTF-8"));
+    }
+
+    std::vector<uint8_t>& m_out;
+    const bool m_checkUtf8;
+};
+}
+
+// Borrowed strings and binaries are views into 'content', which the arena keeps
+static std::shared_ptr<StringArena> AdoptContent(std::vector<uint8_t> content, const uint8_t*& data)
+{
+    std::shared_ptr<StringArena> arena = std::make_shared<StringArena>();
+    data = arena->Adopt(std::move(content));
+    return arena;
+}
+
+static MappingNode Load(const uint8_t* data, const size_t size, std::shared_ptr<StringArena> arena)
+{
+    ParseResult result;
+    if (!Reader(data, size, result.error, std::move(arena)).Run(result.node))
+        XE_THROW(std::runtime_error(result.error.message + " (at byte " + std::to_string(result.error.offset) + ")"));
+    return std::move(result.node);
 }
 
 MappingNode xe::BSONFormatter::LoadFile(const std::filesystem::path& path)
 {
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    size_t length = file.tellg();
-    
-    if (length == 0)
+    std::vector<uint8_t> content = FileIO::ReadFile(path);
+
+    if (content.empty())
         return MappingNode();
-    
-    file.seekg(0, std::ios::beg);
-    std::vector<uint8_t> content(length);
-    file.read((char*)content.data(), length);
-    return LoadContent(content);
+
+    if (m_borrowStrings)
+    {
+        // The file buffer itself backs the borrowed values: no copy at all
+        const size_t size = content.size();
+        const uint8_t* data;
+        std::shared_ptr<StringArena> arena = AdoptContent(std::move(content), data);
+        return Load(data, size, std::move(arena));
+    }
+    return Load(content.data(), content.size(), nullptr);
 }
 
 MappingNode xe::BSONFormatter::LoadContent(const std::vector<uint8_t>& content)
 {
-    json in = json::from_bson(content);
-    MappingNode result;
-    Import(in, result);
+    return LoadContent(content.data(), content.size());
+}
+
+MappingNode xe::BSONFormatter::LoadContent(const uint8_t* data, size_t size)
+{
+    // With borrowing, one copy of the whole input instead of one per string and binary
+    std::shared_ptr<StringArena> arena;
+    if (m_borrowStrings)
+        arena = AdoptContent(std::vector<uint8_t>(data, data + size), data);
+    return Load(data, size, std::move(arena));
+}
+
+ParseResult xe::BSONFormatter::TryLoadContent(const uint8_t* data, size_t size)
+{
+    std::shared_ptr<StringArena> arena;
+    if (m_borrowStrings)
+        arena = AdoptContent(std::vector<uint8_t>(data, data + size), data);
+
+    ParseResult result;
+    Reader(data, size, result.error, std::move(arena)).Run(result.node);
     return result;
 }
 
@@ -192,17 +493,11 @@ bool xe::BSONFormatter::SaveFile(const MappingNode& node, const std::filesystem:
 {
     std::vector<uint8_t> content;
     SaveContent(node, content);
-    std::ofstream file(path, std::ios::binary | std::ios::trunc);
-    if (!file.is_open())
-        return false;
-    
-    file.write((char*)content.data(), content.size());
-    return true;
+    return FileIO::WriteFile(path, content.data(), content.size());
 }
 
 void xe::BSONFormatter::SaveContent(const MappingNode& node, std::vector<uint8_t>& out_content)
 {
-    json content;
-    Export(content, node);
-    out_content = json::to_bson(content);
+    out_content.clear();
+    Writer(out_content, m_checkUtf8OnSave).Run(node);
 }
@@ -0,0 +1,316 @@
+/*========================================================
+
+ XEMarkup - ArrayIndex
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_ARRAYINDEX_H
+#define XE_ARRAYINDEX_H
+
+#include "Exceptions.h"
+#include "MappingNode.h"
+#include "Path.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xe
+{
+    // Index over one field of an array of mappings, e.g. the "id" of every entry in "items".
+    // Kind::Hash gives O(1) point lookups; Kind::Sorted gives O(log n) lookups plus Range().
+    // The index remembers the array's Version() and rebuilds itself on the next lookup once that
+    // moves on, which any write under the array does, including one made through a reference to
+    // an element kept from before. Checking costs O(1); writes elsewhere cost nothing. The array
+    // must stay at the same address while indexed.
+    // Lookups may rebuild the index, so like any non-const call they must not run concurrently
+    // with each other; give each thread its own index or guard it.
+    // Elements that are not mappings or that lack the field are left out.
+    class ArrayIndex
+    {
+    public:
+        enum class Kind : uint8_t
+        {
+            Hash,
+            Sorted,
+        };
+
+        static constexpr size_t s_npos = static_cast<size_t>(-1);
+
+        ArrayIndex(const MappingNode& array, Path field, const Kind kind = Kind::Hash)
+            : m_array(&array), m_field(std::move(field)), m_kind(kind)
+        {
+            Rebuild();
+        }
+
+        Kind GetKind() const noexcept { return m_kind; }
+        const Path& Field() const noexcept { return m_field; }
+
+        // True if the array has changed since the index was built
+        bool IsStale() const noexcept
+        {
+            return m_array->Version() != m_arrayVersion;
+        }
+
+        // Rebuilds only if stale; returns whether it did
+        bool Refresh()
+        {
+            if (!IsStale())
+            {
+                return false;
+            }
+            Rebuild();
+            return true;
+        }
+
+        void Rebuild()
+        {
+            if (!m_array->IsArray() && m_array->IsDefined())
+            {
+                XE_THROW(std::runtime_error("ArrayIndex needs an array node"));
+            }
+
+            m_hashed.clear();
+            m_sorted.clear();
+            const size_t size = m_array->IsArray() ? m_array->Size() : 0;
+            if (m_kind == Kind::Hash)
+            {
+                m_hashed.reserve(size);
+            }
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                const MappingNode* value = FieldOf(i);
+                if (!value)
+                {
+                    continue;
+                }
+                if (m_kind == Kind::Hash)
+                {
+                    m_hashed.emplace(value->Hash(), i);
+                }
+                else
+                {
+                    m_sorted.push_back(i);
+                }
+            }
+
+            if (m_kind == Kind::Sorted)
+            {
+                std::stable_sort(m_sorted.begin(), m_sorted.end(), [this](size_t a, size_t b)
+                {
+                    return Compare(*FieldOf(a), *FieldOf(b)) < 0;
+                });
+            }
+            m_arrayVersion = m_array->Version();
+        }
+
+        // Position of the first element whose field equals 'value', or s_npos
+        size_t IndexOf(const MappingNode& value)
+        {
+            Refresh();
+            if (m_kind == Kind::Hash)
+            {
+                size_t best = s_npos;
+                auto range = m_hashed.equal_range(value.Hash());
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    if (it->second < best && *FieldOf(it->second) == value)
+                    {
+                        best = it->second;
+                    }
+                }
+                return best;
+            }
+
+            auto range = EqualRange(value, value);
+            return (range.first != range.second) ? *range.first : s_npos;
+        }
+
+        const MappingNode* Find(const MappingNode& value)
+        {
+            size_t index = IndexOf(value);
+            return (index != s_npos) ? &(*m_array)[index] : nullptr;
+        }
+
+        // Every element whose field equals 'value', in array order
+        std::vector<const MappingNode*> FindAll(const MappingNode& value)
+        {
+            Refresh();
+            std::vector<size_t> indices;
+            if (m_kind == Kind::Hash)
+            {
+                auto range = m_hashed.equal_range(value.Hash());
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    if (*FieldOf(it->second) == value)
+                    {
+                        indices.push_back(it->second);
+                    }
+                }
+                std::sort(indices.begin(), indices.end());
+            }
+            else
+            {
+                auto range = EqualRange(value, value);
+                indices.assign(range.first, range.second);
+            }
+            return Elements(indices);
+        }
+
+        // Elements whose field lies in [low, high], ordered by field. Kind::Sorted only.
+        std::vector<const MappingNode*> Range(const MappingNode& low, const MappingNode& high)
+        {
+            if (m_kind != Kind::Sorted)
+            {
+                XE_THROW(std::runtime_error("Range needs a sorted ArrayIndex"));
+            }
+            Refresh();
+            auto range = EqualRange(low, high);
+            return Elements(std::vector<size_t>(range.first, range.second));
+        }
+
+        // Convenience overloads for plain values: Find(42), Find("sword")
+        template<typename T>
+        std::enable_if_t<!std::is_base_of_v<MappingNode, T>, const MappingNode*> Find(const T& value)
+        {
+            return Find(Wrap(value));
+        }
+
+        template<typename T>
+        std::enable_if_t<!std::is_base_of_v<MappingNode, T>, size_t> IndexOf(const T& value)
+        {
+            return IndexOf(Wrap(value));
+        }
+
+        template<typename T>
+        std::enable_if_t<!std::is_base_of_v<MappingNode, T>, std::vector<const MappingNode*>> FindAll(const T& value)
+        {
+            return FindAll(Wrap(value));
+        }
+
+        template<typename T>
+        std::enable_if_t<!std::is_base_of_v<MappingNode, T>, std::vector<const MappingNode*>> Range(const T& low, const T& high)
+        {
+            return Range(Wrap(low), Wrap(high));
+        }
+
+    private:
+        template<typename T>
+        static MappingNode Wrap(const T& value)
+        {
+            MappingNode node;
+            node = value;
+            return node;
+        }
+
+        const MappingNode* FieldOf(const size_t index) const noexcept
+        {
+            const MappingNode& element = m_array->begin()[index];
+            return element.IsMapping() ? element.Find(m_field) : nullptr;
+        }
+
+        std::vector<const MappingNode*> Elements(const std::vector<size_t>& indices) const
+        {
+            std::vector<const MappingNode*> result;
+            result.reserve(indices.size());
+            for (size_t index : indices)
+            {
+                result.push_back(&m_array->begin()[index]);
+            }
+            return result;
+        }
+
+        std::pair<std::vector<size_t>::const_iterator, std::vector<size_t>::const_iterator>
+            EqualRange(const MappingNode& low, const MappingNode& high) const
+        {
+            auto first = std::partition_point(m_sorted.begin(), m_sorted.end(),
+                [&](size_t i) { return Compare(*FieldOf(i), low) < 0; });
+            auto last = std::partition_point(first, m_sorted.end(),
+                [&](size_t i) { return Compare(*FieldOf(i), high) <= 0; });
+            return { first, last };
+        }
+
+        // Total order for the sorted index: null < booleans < numbers < strings < anything else,
+        // numbers by value and strings bytewise; values of the last group order by hash
+        static int Compare(const MappingNode& a, const MappingNode& b)
+        {
+            const int rankA = Rank(a), rankB = Rank(b);
+            if (rankA != rankB)
+            {
+                return (rankA < rankB) ? -1 : 1;
+            }
+
+            switch (rankA)
+            {
+            case 0:
+                return 0;
+            case 1:
+                return static_cast<int>(a.As<bool>()) - static_cast<int>(b.As<bool>());
+            case 2:
+            {
+                const double x = a.TryAs<double>().value_or(0.0), y = b.TryAs<double>().value_or(0.0);
+                return (x < y) ? -1 : (x > y) ? 1 : 0;
+            }
+            case 3:
+            {
+                const int result = a.AsStringView().compare(b.AsStringView());
+                return (result < 0) ? -1 : (result > 0) ? 1 : 0;
+            }
+            default:
+            {
+                const uint64_t x = a.Hash(), y = b.Hash();
+                return (x < y) ? -1 : (x > y) ? 1 : 0;
+            }
+            }
+        }
+
+        static int Rank(const MappingNode& node) noexcept
+        {
+            if (!node.IsDefined()) return 0;
+            if (node.IsBoolean()) return 1;
+            if (node.IsNumeric()) return 2;
+            if (node.IsString()) return 3;
+            return 4;
+        }
+
+        struct IdentityHash
+        {
+            size_t operator()(const uint64_t hash) const noexcept { return static_cast<size_t>(hash); }
+        };
+
+        const MappingNode* m_array;
+        Path m_field;
+        Kind m_kind;
+        uint64_t m_arrayVersion = 0;
+        std::unordered_multimap<uint64_t, size_t, IdentityHash> m_hashed; // field hash -> element
+        std::vector<size_t> m_sorted; // elements ordered by field
+    };
+}
+
+#endif // !XE_ARRAYINDEX_H
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*========================================================
+
+ XEMarkup - AsyncSave
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_ASYNCSAVE_H
+#define XE_ASYNCSAVE_H
+
+#include "IFormatter.h"
+#include "MappingNode.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <memory>
+
+namespace xe
+{
+    class SaveHandle
+    {
+    public:
+        SaveHandle() = default;
+        explicit SaveHandle(std::shared_future<bool> result) : m_result(std::move(result)) {}
+
+        bool IsValid() const { return m_result.valid(); }
+
+        // Non-blocking check for completion
+        bool IsDone() const
+        {
+            return m_result.valid() &&
+                m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        // Blocks until written; returns SaveFile's result and rethrows anything serialization threw
+        bool Wait() const
+        {
+            return m_result.get();
+        }
+
+    private:
+        std::shared_future<bool> m_result;
+    };
+
+    // Snapshots 'node' in O(1) with MappingNode::Share() and runs formatter.SaveFile on a
+    // background thread. Saves run one at a time in submission order, so repeated autosaves
+    // to the same path land in order. The formatter must outlive the save.
+    // Share() carries its rule over: references into 'node' taken before the call, such as a
+    // kept MappingNode& to one entry, must not be used to mutate it while the save runs. A
+    // write through one skips the copy-on-write and races with the serializer; look the
+    // entry up again from 'node' after saving instead.
+    inline SaveHandle AsyncSave(IFormatter& formatter, const MappingNode& node, const std::filesystem::path& path)
+    {
+        static ThreadPool writer(1);
+
+        auto task = std::make_shared<std::packaged_task<bool()>>(
+            [&formatter, snapshot = node.Share(), path]()
+            {
+                return formatter.SaveFile(snapshot, path);
+            });
+        SaveHandle result(task->get_future().share());
+        writer.Submit([task]() { (*task)(); });
+        return result;
+    }
+}
+
+#endif // !XE_ASYNCSAVE_H
\ No newline at end of file
@@ -0,0 +1,508 @@
+/*========================================================
+
+ XEMarkup - Base64
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_BASE64_H
+#define XE_BASE64_H
+
+#include "CPUFeatures.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xe
+{
+    // Base64 with the standard alphabet (RFC 4648), for binary nodes in the text formatters.
+    // The x86 paths turn 12 or 24 bytes into 16 or 32 characters per step and back with pshufb
+    // lookups, after Muła and Lemire, "Faster Base64 Encoding and Decoding Using AVX2
+    // Instructions". NEON uses de-interleaving loads and 64-entry table lookups. Path::Auto
+    // picks the widest path the CPU supports.
+    class Base64
+    {
+    public:
+        enum class Path : uint8_t
+        {
+            Auto,
+            Scalar,
+            SSE4,
+            AVX2,
+            NEON,
+        };
+
+        static constexpr size_t EncodedSize(const size_t size) noexcept
+        {
+            return (size + 2) / 3 * 4;
+        }
+
+        // Appends the padded encoding of 'size' bytes at 'data' to 'out'
+        static void Encode(const void* data, const size_t size, std::string& out, Path path = Path::Auto)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            const size_t start = out.size();
+            out.resize(start + EncodedSize(size));
+            char* chars = &out[0] + start;
+
+            size_t done = 0;
+            switch (Resolve(path))
+            {
+#ifdef XE_SIMD_X86
+            case Path::AVX2: done = EncodeAVX2(bytes, size, chars); break;
+            case Path::SSE4: done = EncodeSSE4(bytes, size, chars); break;
+#endif
+#ifdef XE_SIMD_NEON
+            case Path::NEON: done = EncodeNEON(bytes, size, chars); break;
+#endif
+            default: break;
+            }
+            EncodeScalar(bytes + done, size - done, chars + done / 3 * 4);
+        }
+
+        static std::string Encode(const void* data, const size_t size)
+        {
+            std::string result;
+            Encode(data, size, result);
+            return result;
+        }
+
+        // Replaces 'out' with the bytes 'text' encodes. ASCII whitespace is skipped, so wrapped
+        // lines decode too, and padding may be left off. Returns false on any other character
+        // outside the alphabet and on padding that is misplaced or incomplete.
+        static bool Decode(const std::string_view text, std::vector<uint8_t>& out, Path path = Path::Auto)
+        {
+            path = Resolve(path);
+            const uint8_t* table = DecodeTable();
+
+            // The vector paths store whole registers, so leave room past the last byte
+            out.resize(text.size() / 4 * 3 + 3 + 32);
+            uint8_t* bytes = out.data();
+
+            uint32_t bits = 0;
+            size_t pending = 0; // characters in 'bits', up to a group of four
+            size_t padding = 0; // '=' seen
+            size_t expected = 0; // '=' the last group needs
+            size_t i = 0;
+            while (i < text.size())
+            {
+                if (pending == 0 && padding == 0)
+                {
+                    const size_t done = DecodeBlocks(text.data() + i, text.size() - i, bytes, table, path);
+                    i += done;
+                    bytes += done / 4 * 3;
+                }
+
+                // Whatever stopped the run (whitespace, padding, a bad character, the end) is taken
+                // a character at a time, up to the next group boundary past a short window
+                const size_t window = std::min(text.size(), i + s_scalarWindow);
+                for (; i < text.size() && (i < window || pending != 0); ++i)
+                {
+                    const uint8_t sextet = table[static_cast<uint8_t>(text[i])];
+                    if (sextet == s_space)
+                        continue;
+                    if (sextet == s_pad)
+                    {
+                        if (padding == 0 && pending < 2)
+                            return false;
+                        if (padding == 0)
+                        {
+                            expected = 4 - pending;
+                            bytes = Flush(bits, pending, bytes);
+                        }
+                        if (++padding > expected)
+                            return false;
+                        continue;
+                    }
+                    if (sextet == s_invalid || padding != 0)
+                        return false;
+
+                    bits = (bits << 6) | sextet;
+                    if (++pending == 4)
+                    {
+                        bytes = Flush(bits, pending, bytes);
+                    }
+                }
+            }
+
+            if (padding == 0)
+            {
+                if (pending == 1)
+                    return false;
+                bytes = Flush(bits, pending, bytes);
+            }
+            else if (padding != expected)
+            {
+                return false;
+            }
+
+            out.resize(static_cast<size_t>(bytes - out.data()));
+            return true;
+        }
+
+        // The path Path::Auto resolves to on this machine
+        static Path BestPath()
+        {
+            for (const Path path : { Path::AVX2, Path::NEON, Path::SSE4 })
+            {
+                if (Available(path))
+                    return path;
+            }
+            return Path::Scalar;
+        }
+
+    private:
+        static constexpr char s_alphabet[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        // DecodeTable entries other than sextets; all have the top bit set
+        static constexpr uint8_t s_pad = 0xFD;
+        static constexpr uint8_t s_space = 0xFE;
+        static constexpr uint8_t s_invalid = 0xFF;
+
+        static constexpr size_t s_scalarWindow = 32;
+
+        static bool Available(const Path path)
+        {
+            switch (path)
+            {
+            case Path::Scalar:
+                return true;
+#ifdef XE_SIMD_X86
+            case Path::SSE4:
+                return CPUFeatures::HasSSE41();
+            case Path::AVX2:
+                return CPUFeatures::HasAVX2();
+#endif
+#ifdef XE_SIMD_NEON
+            case Path::NEON:
+                return true;
+#endif
+            default:
+                return false;
+            }
+        }
+
+        static Path Resolve(const Path path)
+        {
+            static const Path best = BestPath();
+            return (path == Path::Auto || !Available(path)) ? best : path;
+        }
+
+        static const uint8_t* DecodeTable()
+        {
+            static const std::array<uint8_t, 256> table = []()
+                {
+                    std::array<uint8_t, 256> result;
+                    result.fill(s_invalid);
+                    for (uint8_t i = 0; i < 64; ++i)
+                        result[static_cast<uint8_t>(s_alphabet[i])] = i;
+                    for (const char c : { ' ', '\t', '\r', '\n' })
+                        result[static_cast<uint8_t>(c)] = s_space;
+                    result['='] = s_pad;
+                    return result;
+                }();
+            return table.data();
+        }
+
+        // Writes the 'pending' sextets in 'bits' out as the whole bytes they hold
+        static uint8_t* Flush(uint32_t& bits, size_t& pending, uint8_t* out) noexcept
+        {
+            bits <<= 6 * (4 - pending);
+            const size_t count = (pending * 6) / 8;
+            for (size_t k = 0; k < count; ++k)
+                *out++ = static_cast<uint8_t>(bits >> (16 - 8 * k));
+            bits = 0;
+            pending = 0;
+            return out;
+        }
+
+        static void EncodeScalar(const uint8_t* in, const size_t size, char* out) noexcept
+        {
+            size_t i = 0;
+            for (; i + 3 <= size; i += 3)
+            {
+                const uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+                *out++ = s_alphabet[v >> 18];
+                *out++ = s_alphabet[(v >> 12) & 63];
+                *out++ = s_alphabet[(v >> 6) & 63];
+                *out++ = s_alphabet[v & 63];
+            }
+            if (i == size)
+                return;
+
+            const uint32_t v = (uint32_t(in[i]) << 16) | ((i + 1 < size) ? uint32_t(in[i + 1]) << 8 : 0);
+            *out++ = s_alphabet[v >> 18];
+            *out++ = s_alphabet[(v >> 12) & 63];
+            *out++ = (i + 1 < size) ? s_alphabet[(v >> 6) & 63] : '=';
+            *out++ = '=';
+        }
+
+        // Whole groups of four alphabet characters, up to the first group holding anything else.
+        // Returns the characters consumed; three bytes are written per four.
+        static size_t DecodeBlocks(const char* text, const size_t size, uint8_t* out, const uint8_t* table, const Path path)
+        {
+            size_t done = 0;
+            switch (path)
+            {
+#ifdef XE_SIMD_X86
+            case Path::AVX2: done = DecodeAVX2(text, size, out); break;
+            case Path::SSE4: done = DecodeSSE4(text, size, out); break;
+#endif
+#ifdef XE_SIMD_NEON
+            case Path::NEON: done = DecodeNEON(text, size, out, table); break;
+#endif
+            default: break;
+            }
+
+            out += done / 4 * 3;
+            for (; done + 4 <= size; done += 4)
+            {
+                const uint32_t a = table[static_cast<uint8_t>(text[done])];
+                const uint32_t b = table[static_cast<uint8_t>(text[done + 1])];
+                const uint32_t c = table[static_cast<uint8_t>(text[done + 2])];
+                const uint32_t d = table[static_cast<uint8_t>(text[done + 3])];
+                if ((a | b | c | d) & 0x80)
+                    break;
+
+                const uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+                *out++ = static_cast<uint8_t>(v >> 16);
+                *out++ = static_cast<uint8_t>(v >> 8);
+                *out++ = static_cast<uint8_t>(v);
+            }
+            return done;
+        }
+
+#ifdef XE_SIMD_X86
+        // Sextet indices to characters: each range of the alphabet is an offset from its index
+        XE_TARGET_SSE4 static __m128i EncodeLanes(__m128i in)
+        {
+            // 3 bytes -> 4 sextets per 32-bit lane, each in a byte of its own
+            in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            const __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+            const __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+            const __m128i indices = _mm_or_si128(high, low);
+
+            // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+            __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+            const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+            return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+        }
+
+        XE_TARGET_SSE4 static size_t EncodeSSE4(const uint8_t* in, const size_t size, char* out)
+        {
+            // Each step reads 16 bytes and uses 12
+            size_t i = 0;
+            for (; i + 16 <= size; i += 12, out += 16)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), EncodeLanes(v));
+            }
+            return i;
+        }
+
+        // Characters to sextets; false if any is outside the alphabet
+        XE_TARGET_SSE4 static bool DecodeLanes(const __m128i in, __m128i& out)
+        {
+            const __m128i high = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+            const __m128i low = _mm_and_si128(in, _mm_set1_epi8(0x0F));
+
+            // Bit 'high' of the entry for 'low' is set when high:low is in the alphabet
+            const __m128i valid = _mm_setr_epi8(static_cast<char>(0xA8), static_cast<char>(0xF8), static_cast<char>(0xF8),
+                static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8),
+                static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF0),
+                0x54, 0x50, 0x50, 0x50, 0x54);
+            const __m128i bit = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+                0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(valid, low), _mm_shuffle_epi8(bit, high)), _mm_setzero_si128());
+            if (_mm_movemask_epi8(invalid) != 0)
+                return false;
+
+            // Every range shares its high nibble but '/', which sits beside '+'
+            const __m128i offsets = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i offset = _mm_blendv_epi8(_mm_shuffle_epi8(offsets, high), _mm_set1_epi8(16), _mm_cmpeq_epi8(in, _mm_set1_epi8('/')));
+            const __m128i sextets = _mm_add_epi8(in, offset);
+
+            // 4 sextets -> 3 bytes per 32-bit lane, then the lanes packed into the low 12 bytes
+            const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+            const __m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            out = _mm_shuffle_epi8(words, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            return true;
+        }
+
+        XE_TARGET_SSE4 static size_t DecodeSSE4(const char* text, const size_t size, uint8_t* out)
+        {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16, out += 12)
+            {
+                __m128i bytes;
+                if (!DecodeLanes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), bytes))
+                    break;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+            }
+            return i;
+        }
+
+        XE_TARGET_AVX2 static __m256i EncodeLanes(__m256i in)
+        {
+            in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            const __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+            const __m256i low = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+            const __m256i indices = _mm256_or_si256(high, low);
+
+            __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+            const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+            return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+        }
+
+        XE_TARGET_AVX2 static size_t EncodeAVX2(const uint8_t* in, const size_t size, char* out)
+        {
+            // 12 bytes into each 128-bit lane; the second load reads 4 bytes past the 24 used
+            size_t i = 0;
+            for (; i + 28 <= size; i += 24, out += 32)
+            {
+                const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+                const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), EncodeLanes(v));
+            }
+            return i;
+        }
+
+        XE_TARGET_AVX2 static bool DecodeLanes(const __m256i in, __m256i& out)
+        {
+            const __m256i high = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0F));
+            const __m256i low = _mm256_and_si256(in, _mm256_set1_epi8(0x0F));
+
+            const __m256i valid = _mm256_setr_epi8(static_cast<char>(0xA8), static_cast<char>(0xF8), static_cast<char>(0xF8),
+                static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8),
+                static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF0),
+                0x54, 0x50, 0x50, 0x50, 0x54,
+                static_cast<char>(0xA8), static_cast<char>(0xF8), static_cast<char>(0xF8),
+                static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8),
+                static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF8), static_cast<char>(0xF0),
+                0x54, 0x50, 0x50, 0x50, 0x54);
+            const __m256i bit = _mm256_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+                0, 0, 0, 0, 0, 0, 0, 0,
+                0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+                0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i invalid = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_shuffle_epi8(valid, low), _mm256_shuffle_epi8(bit, high)), _mm256_setzero_si256());
+            if (_mm256_movemask_epi8(invalid) != 0)
+                return false;
+
+            const __m256i offsets = _mm256_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i offset = _mm256_blendv_epi8(_mm256_shuffle_epi8(offsets, high), _mm256_set1_epi8(16), _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/')));
+            const __m256i sextets = _mm256_add_epi8(in, offset);
+
+            const __m256i pairs = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+            const __m256i words = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+            const __m256i packed = _mm256_shuffle_epi8(words, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+            // The 12 bytes of each lane side by side in the low 24
+            out = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+            return true;
+        }
+
+        XE_TARGET_AVX2 static size_t DecodeAVX2(const char* text, const size_t size, uint8_t* out)
+        {
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32, out += 24)
+            {
+                __m256i bytes;
+                if (!DecodeLanes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)), bytes))
+                    break;
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), bytes);
+            }
+            return i;
+        }
+#endif // XE_SIMD_X86
+
+#ifdef XE_SIMD_NEON
+        static uint8x16x4_t LoadTable(const uint8_t* table)
+        {
+            return { { vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32), vld1q_u8(table + 48) } };
+        }
+
+        // 48 bytes are loaded split three ways, so each sextet is a few shifts of one register
+        static size_t EncodeNEON(const uint8_t* in, const size_t size, char* out)
+        {
+            const uint8x16x4_t alphabet = LoadTable(reinterpret_cast<const uint8_t*>(s_alphabet));
+            const uint8x16_t mask = vdupq_n_u8(0x3F);
+
+            size_t i = 0;
+            for (; i + 48 <= size; i += 48, out += 64)
+            {
+                const uint8x16x3_t v = vld3q_u8(in + i);
+                uint8x16x4_t chars;
+                chars.val[0] = vqtbl4q_u8(alphabet, vshrq_n_u8(v.val[0], 2));
+                chars.val[1] = vqtbl4q_u8(alphabet, vandq_u8(vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), mask));
+                chars.val[2] = vqtbl4q_u8(alphabet, vandq_u8(vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), mask));
+                chars.val[3] = vqtbl4q_u8(alphabet, vandq_u8(v.val[2], mask));
+                vst4q_u8(reinterpret_cast<uint8_t*>(out), chars);
+            }
+            return i;
+        }
+
+        static size_t DecodeNEON(const char* text, const size_t size, uint8_t* out, const uint8_t* table)
+        {
+            // The decode table's first 128 entries; anything at or above 0x80 is caught by its top bit
+            const uint8x16x4_t low = LoadTable(table);
+            const uint8x16x4_t high = LoadTable(table + 64);
+
+            size_t i = 0;
+            for (; i + 64 <= size; i += 64, out += 48)
+            {
+                const uint8x16x4_t v = vld4q_u8(reinterpret_cast<const uint8_t*>(text + i));
+                uint8x16_t sextets[4];
+                uint8x16_t bad = vdupq_n_u8(0);
+                for (int k = 0; k < 4; ++k)
+                {
+                    sextets[k] = vqtbx4q_u8(vqtbl4q_u8(low, v.val[k]), high, vsubq_u8(v.val[k], vdupq_n_u8(64)));
+                    bad = vorrq_u8(bad, vorrq_u8(sextets[k], v.val[k]));
+                }
+                if (vmaxvq_u8(bad) >= 0x80)
+                    break;
+
+                uint8x16x3_t bytes;
+                bytes.val[0] = vorrq_u8(vshlq_n_u8(sextets[0], 2), vshrq_n_u8(sextets[1], 4));
+                bytes.val[1] = vorrq_u8(vshlq_n_u8(sextets[1], 4), vshrq_n_u8(sextets[2], 2));
+                bytes.val[2] = vorrq_u8(vshlq_n_u8(sextets[2], 6), sextets[3]);
+                vst3q_u8(out, bytes);
+            }
+            return i;
+        }
+#endif // XE_SIMD_NEON
+    };
+}
+
+#endif // !XE_BASE64_H
\ No newline at end of file
@@ -0,0 +1,187 @@
+/*========================================================
+
+ XEMarkup - BatchLoader
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_BATCHLOADER_H
+#define XE_BATCHLOADER_H
+
+#include "IFormatter.h"
+#include "MappingNode.h"
+#include "ThreadPool.h"
+
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace xe
+{
+    // Loads many files concurrently. A formatter may appear in several entries at once,
+    // so its LoadFile must be safe to call from multiple threads (the built-in ones are).
+    class BatchLoader
+    {
+    public:
+        struct Entry
+        {
+            std::filesystem::path path;
+            IFormatter* formatter = nullptr;
+        };
+
+        // error is null on success; otherwise node is empty and error holds what LoadFile threw.
+        // Must not throw: it runs on a pool worker, so anything it throws is discarded.
+        using Callback = std::function<void(const std::filesystem::path& path, MappingNode&& node, std::exception_ptr error)>;
+
+        explicit BatchLoader(size_t threadCount = 0) : m_pool(threadCount) {}
+
+        // Waits for outstanding loads
+        ~BatchLoader()
+        {
+            Wait();
+        }
+
+        BatchLoader(const BatchLoader&) = delete;
+        BatchLoader& operator=(const BatchLoader&) = delete;
+
+        std::future<MappingNode> Load(const std::filesystem::path& path, IFormatter& formatter)
+        {
+            auto promise = std::make_shared<std::promise<MappingNode>>();
+            std::future<MappingNode> result = promise->get_future();
+
+            Dispatch([path, &formatter, promise]()
+                {
+                    try
+                    {
+                        promise->set_value(formatter.LoadFile(path));
+                    }
+                    catch (...)
+                    {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+            return result;
+        }
+
+        void Load(const std::filesystem::path& path, IFormatter& formatter, Callback onComplete)
+        {
+            Dispatch([path, &formatter, onComplete = std::move(onComplete)]()
+                {
+                    MappingNode node;
+                    std::exception_ptr error;
+                    try
+                    {
+                        node = formatter.LoadFile(path);
+                    }
+                    catch (...)
+                    {
+                        error = std::current_exception();
+                    }
+                    onComplete(path, std::move(node), error);
+                });
+        }
+
+        // Futures are returned in entry order; a failed file rethrows from its own future only
+        std::vector<std::future<MappingNode>> Load(const std::vector<Entry>& entries)
+        {
+            std::vector<std::future<MappingNode>> result;
+            result.reserve(entries.size());
+            for (const Entry& entry : entries)
+            {
+                result.push_back(Load(entry.path, *entry.formatter));
+            }
+            return result;
+        }
+
+        // onComplete is called from worker threads, in completion order
+        void Load(const std::vector<Entry>& entries, const Callback& onComplete)
+        {
+            for (const Entry& entry : entries)
+            {
+                Load(entry.path, *entry.formatter, onComplete);
+            }
+        }
+
+        // Blocks until every load submitted so far has finished
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [this]() { return m_outstanding == 0; });
+        }
+
+    private:
+        // Ends one outstanding load however its job leaves, so Wait() cannot block forever
+        struct Finisher
+        {
+            BatchLoader& loader;
+            ~Finisher() { loader.Finish(); }
+        };
+
+        void Dispatch(std::function<void()> job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_outstanding;
+            }
+
+            try
+            {
+                m_pool.Submit([this, job = std::move(job)]()
+                    {
+                        Finisher finisher{ *this };
+                        try
+                        {
+                            job();
+                        }
+                        catch (...)
+                        {
+                            // A throwing callback; letting it escape would terminate the worker
+                        }
+                    });
+            }
+            catch (...)
+            {
+                Finish();
+                throw;
+            }
+        }
+
+        void Finish()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_outstanding == 0)
+            {
+                m_idle.notify_all();
+            }
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+        size_t m_outstanding = 0;
+        ThreadPool m_pool;
+    };
+}
+
+#endif // !XE_BATCHLOADER_H
\ No newline at end of file
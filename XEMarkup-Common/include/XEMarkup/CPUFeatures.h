@@ -0,0 +1,100 @@
+/*========================================================
+
+ XEMarkup - CPUFeatures
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_CPUFEATURES_H
+#define XE_CPUFEATURES_H
+
+// Instruction sets for the vectorized kernels. XE_SIMD_X86 or XE_SIMD_NEON says which
+// intrinsics the build has; AVX2 and SSE4.1 code is compiled per function with XE_TARGET_*
+// and only called once CPUFeatures has confirmed the CPU runs it.
+#if defined(__x86_64__) || defined(_M_X64)
+#define XE_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define XE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define XE_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define XE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define XE_TARGET_SSE4
+#define XE_TARGET_AVX2
+#endif
+
+namespace xe
+{
+    class CPUFeatures
+    {
+    public:
+        static bool HasSSE41()
+        {
+            static const bool result = Detect(false);
+            return result;
+        }
+
+        static bool HasAVX2()
+        {
+            static const bool result = Detect(true);
+            return result;
+        }
+
+    private:
+        static bool Detect(const bool avx2)
+        {
+#if !defined(XE_SIMD_X86)
+            (void)avx2;
+            return false;
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            const int leaves = info[0];
+
+            __cpuid(info, 1);
+            if (!avx2)
+                return (info[2] & (1 << 19)) != 0;
+            if (leaves < 7)
+                return false;
+
+            // The OS must also save the YMM registers
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+                return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return (avx2) ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.1");
+#endif
+        }
+    };
+}
+
+#endif // !XE_CPUFEATURES_H
\ No newline at end of file
@@ -0,0 +1,324 @@
+/*========================================================
+
+ XEMarkup - Diff
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_DIFF_H
+#define XE_DIFF_H
+
+#include "MappingNode.h"
+#include "Path.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xe
+{
+    struct PatchOperation
+    {
+        enum class Op : uint8_t
+        {
+            Add,
+            Remove,
+            Replace,
+        };
+
+        Op op = Op::Replace;
+        std::string path; // JSON Pointer (RFC 6901); "-" appends in an array add
+        MappingNode value; // unused for Remove
+    };
+
+    // Ordered list of operations in the shape of a JSON Patch (RFC 6902) document.
+    // Assigning it to a MappingNode gives an array of { op, path, value } mappings, so a patch
+    // round-trips through any IFormatter.
+    class Patch : public IMappable
+    {
+    public:
+        std::vector<PatchOperation> operations;
+
+        bool Empty() const noexcept { return operations.empty(); }
+
+        void Map(MappingNode& node) const override
+        {
+            node.Clear();
+            for (const PatchOperation& operation : operations)
+            {
+                MappingNode entry;
+                entry["op"] = (operation.op == PatchOperation::Op::Add) ? "add" :
+                    (operation.op == PatchOperation::Op::Remove) ? "remove" : "replace";
+                entry["path"] = operation.path;
+                if (operation.op != PatchOperation::Op::Remove)
+                {
+                    entry["value"] = operation.value;
+                }
+                node.PushBack(entry);
+            }
+        }
+
+        void Unmap(const MappingNode& node) override
+        {
+            operations.clear();
+            if (!node.IsDefined())
+            {
+                return;
+            }
+            if (!node.IsArray())
+            {
+                throw std::runtime_error("Patch must be an array of operations");
+            }
+
+            for (const MappingNode& entry : node)
+            {
+                PatchOperation operation;
+                std::string op = entry["op"].As<std::string>();
+                if (op == "add") operation.op = PatchOperation::Op::Add;
+                else if (op == "remove") operation.op = PatchOperation::Op::Remove;
+                else if (op == "replace") operation.op = PatchOperation::Op::Replace;
+                else throw std::runtime_error("Unsupported patch operation: " + op);
+
+                operation.path = entry["path"].As<std::string>();
+                if (operation.op != PatchOperation::Op::Remove)
+                {
+                    operation.value = entry["value"];
+                }
+                operations.push_back(std::move(operation));
+            }
+        }
+    };
+
+    class PatchBuilder
+    {
+    public:
+        // Subtrees with matching hashes are skipped without being descended into
+        static void Diff(const MappingNode& a, const MappingNode& b, const std::string& path, Patch& out)
+        {
+            if (a == b)
+                return;
+
+            if (a.IsMapping() && b.IsMapping())
+            {
+                for (const MappingNode& child : a)
+                {
+                    std::string childPath = ChildPath(path, child.Key());
+                    if (!b.ContainsKey(child.Key()))
+                        out.operations.push_back({ PatchOperation::Op::Remove, std::move(childPath), MappingNode() });
+                    else
+                        Diff(child, b[std::string(child.Key())], childPath, out);
+                }
+                for (const MappingNode& child : b)
+                {
+                    if (!a.ContainsKey(child.Key()))
+                        out.operations.push_back({ PatchOperation::Op::Add, ChildPath(path, child.Key()), child.Share() });
+                }
+                return;
+            }
+
+            if (a.IsArray() && b.IsArray())
+            {
+                DiffArray(a, b, path, out);
+                return;
+            }
+
+            out.operations.push_back({ PatchOperation::Op::Replace, path, b.Share() });
+        }
+
+        static std::string ChildPath(const std::string& path, const std::string_view key)
+        {
+            std::string result = path;
+            Path::AppendToken(result, key);
+            return result;
+        }
+
+        static std::vector<std::string> SplitPath(const std::string_view path)
+        {
+            if (!path.empty() && path[0] != '/')
+                throw std::runtime_error("Invalid patch path: " + std::string(path));
+            return Path::SplitPointer(path);
+        }
+
+        static size_t ParseIndex(const std::string& token, const size_t limit, const std::string& path)
+        {
+            if (token.empty() || token.find_first_not_of("0123456789") != std::string::npos)
+                throw std::runtime_error("Invalid array index in patch path: " + path);
+            size_t index = std::stoull(token);
+            if (index > limit)
+                throw std::runtime_error("Array index out of range in patch path: " + path);
+            return index;
+        }
+
+    private:
+        // Arrays use an LCS over the elements (after trimming the common prefix/suffix) so an
+        // insertion near the front does not turn into a replace of every later element.
+        // Past s_maxLcsCells it falls back to comparing by index.
+        static void DiffArray(const MappingNode& a, const MappingNode& b, const std::string& path, Patch& out)
+        {
+            size_t prefix = 0;
+            while (prefix < a.Size() && prefix < b.Size() && a[prefix] == b[prefix])
+                ++prefix;
+
+            size_t suffix = 0;
+            while (suffix < a.Size() - prefix && suffix < b.Size() - prefix &&
+                a[a.Size() - 1 - suffix] == b[b.Size() - 1 - suffix])
+                ++suffix;
+
+            const size_t n = a.Size() - prefix - suffix;
+            const size_t m = b.Size() - prefix - suffix;
+
+            if (n * m > s_maxLcsCells)
+            {
+                size_t common = std::min(n, m);
+                for (size_t i = 0; i < common; ++i)
+                    Diff(a[prefix + i], b[prefix + i], path + "/" + std::to_string(prefix + i), out);
+                for (size_t i = common; i < m; ++i)
+                    out.operations.push_back({ PatchOperation::Op::Add, path + "/" + std::to_string(prefix + i), b[prefix + i].Share() });
+                for (size_t i = n; i > common; --i)
+                    out.operations.push_back({ PatchOperation::Op::Remove, path + "/" + std::to_string(prefix + i - 1), MappingNode() });
+                return;
+            }
+
+            // lcs[i][j] = LCS length of a[i..n) and b[j..m), matching elements by their cached
+            // hashes; the walk below still compares exactly
+            std::vector<uint64_t> hashA(n), hashB(m);
+            for (size_t i = 0; i < n; ++i)
+                hashA[i] = a[prefix + i].Hash();
+            for (size_t j = 0; j < m; ++j)
+                hashB[j] = b[prefix + j].Hash();
+
+            std::vector<uint32_t> lcs((n + 1) * (m + 1), 0);
+            auto at = [&](size_t i, size_t j) -> uint32_t& { return lcs[i * (m + 1) + j]; };
+            for (size_t i = n; i-- > 0;)
+            {
+                for (size_t j = m; j-- > 0;)
+                {
+                    at(i, j) = (hashA[i] == hashB[j]) ? at(i + 1, j + 1) + 1 :
+                        std::max(at(i + 1, j), at(i, j + 1));
+                }
+            }
+
+            // k tracks the index in the array as already patched
+            size_t i = 0, j = 0, k = prefix;
+            while (i < n || j < m)
+            {
+                if (i < n && j < m && a[prefix + i] == b[prefix + j])
+                {
+                    ++i; ++j; ++k;
+                }
+                else if (i < n && j < m && at(i + 1, j + 1) == at(i, j))
+                {
+                    // Neither element survives: edit one into the other in place
+                    Diff(a[prefix + i], b[prefix + j], path + "/" + std::to_string(k), out);
+                    ++i; ++j; ++k;
+                }
+                else if (j < m && (i == n || at(i, j + 1) >= at(i + 1, j)))
+                {
+                    out.operations.push_back({ PatchOperation::Op::Add, path + "/" + std::to_string(k), b[prefix + j].Share() });
+                    ++j; ++k;
+                }
+                else
+                {
+                    out.operations.push_back({ PatchOperation::Op::Remove, path + "/" + std::to_string(k), MappingNode() });
+                    ++i;
+                }
+            }
+        }
+
+        static constexpr size_t s_maxLcsCells = 1 << 20;
+    };
+
+    // Operations that turn 'a' into 'b'
+    inline Patch Diff(const MappingNode& a, const MappingNode& b)
+    {
+        Patch result;
+        PatchBuilder::Diff(a, b, "", result);
+        return result;
+    }
+
+    // Applies operations in order; throws std::runtime_error on a path that does not resolve
+    inline void ApplyPatch(MappingNode& node, const Patch& patch)
+    {
+        for (const PatchOperation& operation : patch.operations)
+        {
+            std::vector<std::string> tokens = PatchBuilder::SplitPath(operation.path);
+            if (tokens.empty())
+            {
+                if (operation.op == PatchOperation::Op::Remove)
+                    node.Clear();
+                else
+                    node = operation.value;
+                continue;
+            }
+
+            MappingNode* parent = &node;
+            for (size_t i = 0; i + 1 < tokens.size(); ++i)
+            {
+                if (parent->IsMapping() && parent->ContainsKey(tokens[i]))
+                    parent = &(*parent)[tokens[i]];
+                else if (parent->IsArray() && parent->Size() > 0)
+                    parent = &(*parent)[PatchBuilder::ParseIndex(tokens[i], parent->Size() - 1, operation.path)];
+                else if (parent->IsArray())
+                    throw std::runtime_error("Array index out of range in patch path: " + operation.path);
+                else
+                    throw std::runtime_error("Invalid patch path: " + operation.path);
+            }
+
+            const std::string& last = tokens.back();
+            if (parent->IsArray())
+            {
+                if (operation.op == PatchOperation::Op::Add)
+                {
+                    size_t index = (last == "-") ? parent->Size() : PatchBuilder::ParseIndex(last, parent->Size(), operation.path);
+                    parent->Insert(index, operation.value);
+                    continue;
+                }
+
+                if (parent->Size() == 0)
+                    throw std::runtime_error("Array index out of range in patch path: " + operation.path);
+                size_t index = PatchBuilder::ParseIndex(last, parent->Size() - 1, operation.path);
+                if (operation.op == PatchOperation::Op::Remove)
+                    parent->Erase(index);
+                else
+                    (*parent)[index] = operation.value;
+                continue;
+            }
+
+            if (!parent->IsMapping() && !(operation.op == PatchOperation::Op::Add && !parent->IsDefined()))
+                throw std::runtime_error("Invalid patch path: " + operation.path);
+
+            if (operation.op == PatchOperation::Op::Remove)
+            {
+                if (!parent->Erase(last))
+                    throw std::runtime_error("Invalid patch path: " + operation.path);
+                continue;
+            }
+            if (operation.op == PatchOperation::Op::Replace && !parent->ContainsKey(last))
+                throw std::runtime_error("Invalid patch path: " + operation.path);
+
+            (*parent)[last] = operation.value;
+        }
+    }
+}
+
+#endif // !XE_DIFF_H
\ No newline at end of file
@@ -0,0 +1,49 @@
+/*========================================================
+
+ XEMarkup - Exceptions
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_EXCEPTIONS_H
+#define XE_EXCEPTIONS_H
+
+#include <cstdlib>
+
+// Built without exceptions (-fno-exceptions, or /EHs- on MSVC), errors that would have been
+// thrown abort instead. Code that must survive bad input then uses the non-throwing paths:
+// IFormatter::TryLoadContent / TryLoadFile, JSONFormatter::TryLoadLazy, MappingNode::TryAs and
+// MappingNode::Find. XE_THROW still evaluates its argument there, so a value built only to be
+// thrown is not reported as unused.
+// XEMarkup-YAML always needs exceptions, since yaml-cpp reports errors by throwing.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define XE_THROW(exception) throw exception
+#define XE_TRY try
+#define XE_CATCH_ALL catch (...)
+#define XE_RETHROW throw
+#else
+#define XE_NO_EXCEPTIONS
+#define XE_THROW(exception) ((void)(exception), std::abort())
+#define XE_TRY if (true)
+#define XE_CATCH_ALL if (false)
+#define XE_RETHROW
+#endif
+
+#endif // !XE_EXCEPTIONS_H
\ No newline at end of file
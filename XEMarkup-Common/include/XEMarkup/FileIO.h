@@ -0,0 +1,592 @@
+/*========================================================
+
+ XEMarkup - FileIO
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_FILEIO_H
+#define XE_FILEIO_H
+
+#include "Exceptions.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Batched reads/writes go through io_uring on Linux unless XE_NO_IO_URING is defined.
+// Everything falls back to plain blocking I/O when the kernel refuses the ring.
+#if defined(__linux__) && !defined(XE_NO_IO_URING) && __has_include(<linux/io_uring.h>)
+#define XE_IO_URING 1
+#endif
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef XE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace xe
+{
+    struct FileRead
+    {
+        std::filesystem::path path;
+        std::vector<uint8_t> content;
+        std::error_code error;
+    };
+
+    // data must stay alive until the batch returns
+    struct FileWrite
+    {
+        std::filesystem::path path;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        std::error_code error;
+    };
+
+    class FileIO
+    {
+    public:
+        // Blocking single-file helpers used by the formatters' LoadFile / SaveFile
+        static std::vector<uint8_t> ReadFile(const std::filesystem::path& path)
+        {
+            FileRead read{ path, {}, {} };
+            ReadBlocking(read);
+            if (read.error)
+            {
+                XE_THROW(std::runtime_error("Could not open file: " + path.string()));
+            }
+            return std::move(read.content);
+        }
+
+        static bool WriteFile(const std::filesystem::path& path, const void* data, const size_t size)
+        {
+            FileWrite write{ path, static_cast<const uint8_t*>(data), size, {} };
+            WriteBlocking(write);
+            return !write.error;
+        }
+
+        // Batched variants; failures are reported per entry in 'error'
+        static void Read(std::vector<FileRead>& reads)
+        {
+#ifdef XE_IO_URING
+            IoUring ring;
+            if (ring.IsValid())
+            {
+                for (size_t i = 0; i < reads.size(); i += ring.Capacity())
+                {
+                    size_t count = std::min(ring.Capacity(), reads.size() - i);
+                    if (ring.IsValid())
+                    {
+                        ReadBatch(ring, reads.data() + i, count);
+                        continue;
+                    }
+                    for (size_t j = i; j < i + count; ++j)
+                    {
+                        ReadBlocking(reads[j]);
+                    }
+                }
+                return;
+            }
+#endif
+            for (FileRead& read : reads)
+            {
+                ReadBlocking(read);
+            }
+        }
+
+        static void Write(std::vector<FileWrite>& writes)
+        {
+#ifdef XE_IO_URING
+            IoUring ring;
+            if (ring.IsValid())
+            {
+                for (size_t i = 0; i < writes.size(); i += ring.Capacity())
+                {
+                    size_t count = std::min(ring.Capacity(), writes.size() - i);
+                    if (ring.IsValid())
+                    {
+                        WriteBatch(ring, writes.data() + i, count);
+                        continue;
+                    }
+                    for (size_t j = i; j < i + count; ++j)
+                    {
+                        WriteBlocking(writes[j]);
+                    }
+                }
+                return;
+            }
+#endif
+            for (FileWrite& write : writes)
+            {
+                WriteBlocking(write);
+            }
+        }
+
+        static bool UsesIoUring()
+        {
+#ifdef XE_IO_URING
+            return IoUring().IsValid();
+#else
+            return false;
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        static void ReadBlocking(FileRead& read)
+        {
+            std::ifstream file(read.path, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+            {
+                read.error = std::make_error_code(std::errc::no_such_file_or_directory);
+                return;
+            }
+            read.content.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0, std::ios::beg);
+            file.read(reinterpret_cast<char*>(read.content.data()), read.content.size());
+            if (!file)
+            {
+                read.error = std::make_error_code(std::errc::io_error);
+            }
+        }
+
+        static void WriteBlocking(FileWrite& write)
+        {
+            std::ofstream file(write.path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                write.error = std::make_error_code(std::errc::permission_denied);
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(write.data), write.size);
+            if (!file)
+            {
+                write.error = std::make_error_code(std::errc::io_error);
+            }
+        }
+#else
+        static std::error_code LastError() { return std::error_code(errno, std::generic_category()); }
+
+        // Reads from 'offset' to the end of the file, growing content as needed
+        static std::error_code ReadRemaining(const int fd, std::vector<uint8_t>& content, size_t offset)
+        {
+            struct stat info;
+            if (fstat(fd, &info) != 0)
+                return LastError();
+
+            content.resize(std::max(offset, static_cast<size_t>(info.st_size)));
+            while (offset < content.size())
+            {
+                ssize_t count = pread(fd, content.data() + offset, content.size() - offset, offset);
+                if (count < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return LastError();
+                }
+                if (count == 0)
+                    break;
+                offset += count;
+            }
+            content.resize(offset);
+            return {};
+        }
+
+        static std::error_code WriteRemaining(const int fd, const uint8_t* data, const size_t size, size_t offset)
+        {
+            while (offset < size)
+            {
+                ssize_t count = pwrite(fd, data + offset, size - offset, offset);
+                if (count < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return LastError();
+                }
+                offset += count;
+            }
+            return {};
+        }
+
+        static void ReadBlocking(FileRead& read)
+        {
+            int fd = open(read.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                read.error = LastError();
+                return;
+            }
+            read.error = ReadRemaining(fd, read.content, 0);
+            close(fd);
+        }
+
+        static void WriteBlocking(FileWrite& write)
+        {
+            int fd = open(write.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                write.error = LastError();
+                return;
+            }
+            write.error = WriteRemaining(fd, write.data, write.size, 0);
+            if (close(fd) != 0 && !write.error)
+            {
+                write.error = LastError();
+            }
+        }
+#endif
+
+#ifdef XE_IO_URING
+        // Minimal io_uring wrapper: fill a batch of SQEs, submit them in one syscall, reap all CQEs.
+        class IoUring
+        {
+        public:
+            IoUring()
+            {
+                io_uring_params params{};
+                m_fd = static_cast<int>(syscall(__NR_io_uring_setup, s_entries, &params));
+                if (m_fd < 0)
+                    return;
+
+                m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                if (params.features & IORING_FEAT_SINGLE_MMAP)
+                {
+                    m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+                }
+
+                m_sqRing = Map(m_sqRingSize, IORING_OFF_SQ_RING);
+                m_cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? m_sqRing : Map(m_cqRingSize, IORING_OFF_CQ_RING);
+                m_sqeSize = params.sq_entries * sizeof(io_uring_sqe);
+                m_sqes = static_cast<io_uring_sqe*>(Map(m_sqeSize, IORING_OFF_SQES));
+                if (!m_sqRing || !m_cqRing || !m_sqes)
+                {
+                    Close();
+                    return;
+                }
+
+                uint8_t* sq = static_cast<uint8_t*>(m_sqRing);
+                m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+                uint8_t* cq = static_cast<uint8_t*>(m_cqRing);
+                m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            }
+
+            ~IoUring() { Close(); }
+
+            IoUring(const IoUring&) = delete;
+            IoUring& operator=(const IoUring&) = delete;
+
+            bool IsValid() const { return m_fd >= 0; }
+            size_t Capacity() const { return s_entries; }
+
+            // Slot i of the current batch; user_data carries i back in the completion
+            io_uring_sqe& Prepare(const size_t i, const uint8_t opcode)
+            {
+                unsigned index = (*m_sqTail + static_cast<unsigned>(i)) & m_sqMask;
+                io_uring_sqe& sqe = m_sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = opcode;
+                sqe.user_data = i;
+                m_sqArray[index] = index;
+                return sqe;
+            }
+
+            // Submits 'count' prepared entries and stores each result (or -errno) in results[user_data]
+            bool Submit(const size_t count, int* results)
+            {
+                __atomic_store_n(m_sqTail, *m_sqTail + static_cast<unsigned>(count), __ATOMIC_RELEASE);
+
+                size_t submitted = 0;
+                size_t completed = 0;
+                while (completed < count)
+                {
+                    unsigned toSubmit = static_cast<unsigned>(count - submitted);
+                    int result = static_cast<int>(syscall(__NR_io_uring_enter, m_fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+                    if (result < 0)
+                    {
+                        if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                            continue;
+
+                        // The ring state is unknown now; later batches take the blocking path
+                        Close();
+                        return false;
+                    }
+                    submitted += result;
+
+                    unsigned head = *m_cqHead;
+                    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+                    for (; head != tail; ++head, ++completed)
+                    {
+                        const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                        results[cqe.user_data] = cqe.res;
+                    }
+                    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+                }
+                return true;
+            }
+
+        private:
+            void* Map(const size_t size, const off_t offset)
+            {
+                void* result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+                return (result == MAP_FAILED) ? nullptr : result;
+            }
+
+            void Close()
+            {
+                if (m_sqes) munmap(m_sqes, m_sqeSize);
+                if (m_cqRing && m_cqRing != m_sqRing) munmap(m_cqRing, m_cqRingSize);
+                if (m_sqRing) munmap(m_sqRing, m_sqRingSize);
+                if (m_fd >= 0) close(m_fd);
+                m_sqes = nullptr;
+                m_cqRing = m_sqRing = nullptr;
+                m_fd = -1;
+            }
+
+            static constexpr unsigned s_entries = 64;
+
+            int m_fd = -1;
+            void* m_sqRing = nullptr;
+            void* m_cqRing = nullptr;
+            io_uring_sqe* m_sqes = nullptr;
+            size_t m_sqRingSize = 0;
+            size_t m_cqRingSize = 0;
+            size_t m_sqeSize = 0;
+
+            unsigned* m_sqTail = nullptr;
+            unsigned m_sqMask = 0;
+            unsigned* m_sqArray = nullptr;
+            unsigned* m_cqHead = nullptr;
+            unsigned* m_cqTail = nullptr;
+            unsigned m_cqMask = 0;
+            io_uring_cqe* m_cqes = nullptr;
+        };
+
+        static bool Unsupported(const int result) { return result == -EINVAL || result == -EOPNOTSUPP; }
+
+        // Open all, read all (speculatively sized), close all: three submissions per batch.
+        // Files larger than the read-ahead or kernels missing an opcode finish on the blocking path.
+        static void ReadBatch(IoUring& ring, FileRead* reads, const size_t count)
+        {
+            std::vector<int> fds(count, -1);
+            std::vector<int> results(count, 0);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                io_uring_sqe& sqe = ring.Prepare(i, IORING_OP_OPENAT);
+                sqe.fd = AT_FDCWD;
+                sqe.addr = reinterpret_cast<uint64_t>(reads[i].path.c_str());
+                sqe.open_flags = O_RDONLY | O_CLOEXEC;
+            }
+            if (!ring.Submit(count, fds.data()))
+            {
+                // Opens completed before the failure still hold their fds
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (fds[i] >= 0)
+                        close(fds[i]);
+                    ReadBlocking(reads[i]);
+                }
+                return;
+            }
+
+            size_t opened = 0;
+            std::vector<size_t> slots(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (fds[i] < 0)
+                {
+                    if (Unsupported(fds[i]))
+                        ReadBlocking(reads[i]);
+                    else
+                        reads[i].error = std::error_code(-fds[i], std::generic_category());
+                    continue;
+                }
+
+                reads[i].content.resize(s_readAhead);
+                io_uring_sqe& sqe = ring.Prepare(opened, IORING_OP_READ);
+                sqe.fd = fds[i];
+                sqe.addr = reinterpret_cast<uint64_t>(reads[i].content.data());
+                sqe.len = s_readAhead;
+                sqe.off = 0;
+                slots[opened++] = i;
+            }
+            if (opened == 0)
+                return;
+
+            if (!ring.Submit(opened, results.data()))
+                std::fill(results.begin(), results.end(), -EOPNOTSUPP);
+
+            for (size_t j = 0; j < opened; ++j)
+            {
+                FileRead& read = reads[slots[j]];
+                int fd = fds[slots[j]];
+                if (results[j] < 0 && !Unsupported(results[j]))
+                {
+                    read.error = std::error_code(-results[j], std::generic_category());
+                    read.content.clear();
+                }
+                else if (results[j] < 0 || static_cast<size_t>(results[j]) == s_readAhead)
+                {
+                    read.error = ReadRemaining(fd, read.content, std::max(results[j], 0));
+                }
+                else
+                {
+                    read.content.resize(results[j]);
+                }
+            }
+
+            if (ring.IsValid())
+            {
+                for (size_t j = 0; j < opened; ++j)
+                {
+                    io_uring_sqe& sqe = ring.Prepare(j, IORING_OP_CLOSE);
+                    sqe.fd = fds[slots[j]];
+                }
+            }
+            if (!ring.IsValid() || !ring.Submit(opened, results.data()))
+            {
+                for (size_t j = 0; j < opened; ++j)
+                    close(fds[slots[j]]);
+                return;
+            }
+
+            for (size_t j = 0; j < opened; ++j)
+            {
+                if (Unsupported(results[j]))
+                    close(fds[slots[j]]);
+            }
+        }
+
+        static void WriteBatch(IoUring& ring, FileWrite* writes, const size_t count)
+        {
+            std::vector<int> fds(count, -1);
+            std::vector<int> results(count, 0);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                io_uring_sqe& sqe = ring.Prepare(i, IORING_OP_OPENAT);
+                sqe.fd = AT_FDCWD;
+                sqe.addr = reinterpret_cast<uint64_t>(writes[i].path.c_str());
+                sqe.open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+                sqe.len = 0644;
+            }
+            if (!ring.Submit(count, fds.data()))
+            {
+                // Opens completed before the failure still hold their fds
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (fds[i] >= 0)
+                        close(fds[i]);
+                    WriteBlocking(writes[i]);
+                }
+                return;
+            }
+
+            size_t opened = 0;
+            std::vector<size_t> slots(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (fds[i] < 0)
+                {
+                    if (Unsupported(fds[i]))
+                        WriteBlocking(writes[i]);
+                    else
+                        writes[i].error = std::error_code(-fds[i], std::generic_category());
+                    continue;
+                }
+
+                io_uring_sqe& sqe = ring.Prepare(opened, IORING_OP_WRITE);
+                sqe.fd = fds[i];
+                sqe.addr = reinterpret_cast<uint64_t>(writes[i].data);
+                sqe.len = static_cast<uint32_t>(writes[i].size);
+                sqe.off = 0;
+                slots[opened++] = i;
+            }
+            if (opened == 0)
+                return;
+
+            if (!ring.Submit(opened, results.data()))
+                std::fill(results.begin(), results.end(), -EOPNOTSUPP);
+
+            for (size_t j = 0; j < opened; ++j)
+            {
+                FileWrite& write = writes[slots[j]];
+                int fd = fds[slots[j]];
+                if (results[j] < 0 && !Unsupported(results[j]))
+                {
+                    write.error = std::error_code(-results[j], std::generic_category());
+                }
+                else if (static_cast<size_t>(std::max(results[j], 0)) < write.size)
+                {
+                    write.error = WriteRemaining(fd, write.data, write.size, std::max(results[j], 0));
+                }
+            }
+
+            if (ring.IsValid())
+            {
+                for (size_t j = 0; j < opened; ++j)
+                {
+                    io_uring_sqe& sqe = ring.Prepare(j, IORING_OP_CLOSE);
+                    sqe.fd = fds[slots[j]];
+                }
+            }
+            if (!ring.IsValid() || !ring.Submit(opened, results.data()))
+            {
+                for (size_t j = 0; j < opened; ++j)
+                    close(fds[slots[j]]);
+                return;
+            }
+
+            for (size_t j = 0; j < opened; ++j)
+            {
+                if (Unsupported(results[j]))
+                    close(fds[slots[j]]);
+                else if (results[j] < 0 && !writes[slots[j]].error)
+                    writes[slots[j]].error = std::error_code(-results[j], std::generic_category());
+            }
+        }
+
+        static constexpr size_t s_readAhead = 16 * 1024;
+#endif
+    };
+}
+
+#endif // !XE_FILEIO_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*========================================================
+
+ XEMarkup - Hash
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_HASH_H
+#define XE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace xe
+{
+    // 64-bit FNV-1a. constexpr so keys can be hashed at compile time.
+    constexpr uint64_t s_hashSeed = 0xcbf29ce484222325ull;
+
+    constexpr uint64_t HashBytes(const char* data, const size_t size, uint64_t hash = s_hashSeed) noexcept
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    inline uint64_t HashBytes(const void* data, const size_t size, const uint64_t hash = s_hashSeed) noexcept
+    {
+        return HashBytes(static_cast<const char*>(data), size, hash);
+    }
+
+    constexpr uint64_t HashString(const std::string_view str, const uint64_t hash = s_hashSeed) noexcept
+    {
+        return HashBytes(str.data(), str.size(), hash);
+    }
+}
+
+#endif // !XE_HASH_H
\ No newline at end of file
@@ -25,10 +25,17 @@
 #ifndef XE_IFORMATTER_H
 #define XE_IFORMATTER_H
 
+#include "FileIO.h"
 #include "MappingNode.h"
+#include "ParseResult.h"
+#include "Projection.h"
 
+#include <cstdint>
 #include <filesystem>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace xe
@@ -40,11 +47,145 @@ namespace xe
 		virtual MappingNode LoadContent(const std::string& content) = 0;
 		virtual MappingNode LoadContent(const std::vector<uint8_t>& content) = 0;
 
+		// Size-aware entry point; the buffer needs no null terminator. Override to parse in place.
+		virtual MappingNode LoadContent(const uint8_t* data, size_t size)
+		{
+			std::vector<uint8_t> content(data, data + size);
+			if (StringContent())
+				content.push_back('\0');
+			return LoadContent(content);
+		}
+
+		// Loads only what 'projection' selects. Formatters that parse from events override this
+		// to pass over everything else without building nodes; the default loads it all and prunes.
+		virtual MappingNode LoadContent(const uint8_t* data, size_t size, const Projection& projection)
+		{
+			return projection.Apply(LoadContent(data, size));
+		}
+
+		MappingNode LoadFile(const std::filesystem::path& path, const Projection& projection)
+		{
+			std::vector<uint8_t> content = FileIO::ReadFile(path);
+			if (content.empty())
+				return MappingNode();
+			return LoadContent(content.data(), content.size(), projection);
+		}
+
 		virtual bool SaveFile(const MappingNode& node, const std::filesystem::path& path) = 0;
 		virtual void SaveContent(const MappingNode& node, std::string& out_content) = 0;
 		virtual void SaveContent(const MappingNode& node, std::vector<uint8_t>& out_content) = 0;
 
 		virtual bool StringContent() const { return true; }; // override for binary based file formats
+
+		// Non-throwing loads: malformed input comes back in ParseResult::error. Formatters
+		// override the buffer variant to report errors without throwing at all; this default
+		// catches what LoadContent throws.
+		virtual ParseResult TryLoadContent(const uint8_t* data, size_t size)
+		{
+			ParseResult result;
+#ifndef XE_NO_EXCEPTIONS
+			try
+			{
+				result.node = LoadContent(data, size);
+			}
+			catch (const std::exception& e)
+			{
+				result.node.Clear();
+				result.error.code = ParseError::Code::Other;
+				result.error.message = e.what();
+			}
+#else
+			result.node = LoadContent(data, size);
+#endif
+			return result;
+		}
+
+		ParseResult TryLoadContent(const std::string_view content)
+		{
+			return TryLoadContent(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+		}
+
+		ParseResult TryLoadFile(const std::filesystem::path& path)
+		{
+			std::vector<FileRead> reads(1);
+			reads[0].path = path;
+			FileIO::Read(reads);
+			if (reads[0].error)
+			{
+				ParseResult result;
+				result.error.code = ParseError::Code::FileAccess;
+				result.error.message = "Could not open file: " + path.string();
+				return result;
+			}
+			if (reads[0].content.empty())
+				return ParseResult();
+			return TryLoadContent(reads[0].content.data(), reads[0].content.size());
+		}
+
+		// When set, loaded string values are borrowed from one StringArena per document
+		// (MappingNode::SetBorrowedString) rather than each owning a copy. BSON borrows binary
+		// values too, as views into the one copy of the input the arena holds.
+		bool GetBorrowStrings() const { return m_borrowStrings; }
+		void SetBorrowStrings(const bool borrowStrings) { m_borrowStrings = borrowStrings; }
+
+		// When set, arrays holding nothing but numbers load as packed arrays
+		// (MappingNode::SetPackedArray): one buffer of doubles instead of a node per element.
+		// Integers a double cannot hold exactly keep the array unpacked. Formatters without a bulk
+		// path for it (BSON, projected loads) build element nodes as usual.
+		bool GetPackNumericArrays() const { return m_packNumericArrays; }
+		void SetPackNumericArrays(const bool packNumericArrays) { m_packNumericArrays = packNumericArrays; }
+
+		// When set, saving checks that every string and key is valid UTF-8 and throws
+		// std::runtime_error if one is not. Otherwise YAML writes U+FFFD in place of a bad
+		// sequence and BSON writes the bytes as they are. JSON always checks, as json::dump does.
+		bool GetCheckUtf8OnSave() const { return m_checkUtf8OnSave; }
+		void SetCheckUtf8OnSave(const bool checkUtf8OnSave) { m_checkUtf8OnSave = checkUtf8OnSave; }
+
+		// Bulk variants: every file is read in one batch (io_uring where available), then parsed
+		std::vector<MappingNode> LoadFiles(const std::vector<std::filesystem::path>& paths)
+		{
+			std::vector<FileRead> reads(paths.size());
+			for (size_t i = 0; i < paths.size(); ++i)
+				reads[i].path = paths[i];
+			FileIO::Read(reads);
+
+			std::vector<MappingNode> result(reads.size());
+			for (size_t i = 0; i < reads.size(); ++i)
+			{
+				if (reads[i].error)
+					XE_THROW(std::runtime_error("Could not open file: " + reads[i].path.string()));
+				if (!reads[i].content.empty())
+					result[i] = LoadContent(reads[i].content.data(), reads[i].content.size());
+			}
+			return result;
+		}
+
+		// Returns false if any file could not be written; the others are still saved
+		bool SaveFiles(const std::vector<std::pair<std::filesystem::path, const MappingNode*>>& files)
+		{
+			std::vector<std::vector<uint8_t>> contents(files.size());
+			std::vector<FileWrite> writes(files.size());
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				SaveContent(*files[i].second, contents[i]);
+				if (StringContent() && !contents[i].empty())
+					contents[i].pop_back(); // drop the null terminator
+				writes[i].path = files[i].first;
+				writes[i].data = contents[i].data();
+				writes[i].size = contents[i].size();
+			}
+			FileIO::Write(writes);
+
+			bool result = true;
+			for (const FileWrite& write : writes)
+				result &= !write.error;
+			return result;
+		}
+
+	protected:
+		bool m_borrowStrings = false;
+		bool m_packNumericArrays = false;
+		bool m_checkUtf8OnSave = false;
 	};
 }
 
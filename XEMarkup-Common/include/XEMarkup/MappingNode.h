@@ -25,17 +25,49 @@
 #ifndef XE_MAPPINGNODE_H
 #define XE_MAPPINGNODE_H
 
+#include "Exceptions.h"
+#include "Hash.h"
+#include "NumberFormat.h"
+#include "Path.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
 
 namespace xe
 {
+    // Read-only view of a binary node's bytes, shaped like std::span<const uint8_t>
+    class ByteSpan
+    {
+    public:
+        constexpr ByteSpan() noexcept = default;
+        constexpr ByteSpan(const uint8_t* data, const size_t size) noexcept : m_data(data), m_size(size) {}
+
+        constexpr const uint8_t* data() const noexcept { return m_data; }
+        constexpr size_t size() const noexcept { return m_size; }
+        constexpr bool empty() const noexcept { return m_size == 0; }
+        constexpr const uint8_t* begin() const noexcept { return m_data; }
+        constexpr const uint8_t* end() const noexcept { return m_data + m_size; }
+        constexpr uint8_t operator[](const size_t index) const noexcept { return m_data[index]; }
+
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
     class MappingNode;
     class IMappable
     {
@@ -55,46 +87,68 @@ namespace xe
             Boolean = 3,
             Array = 4,
             Mapping = 5,
+            Binary = 6,
 
             // Numeric Flags
             FlagMask = 0xF0,
             Decimal = 0x10,
             Negative = 0x20,
+            Raw = 0x40, // source text, parsed on demand
+
+            // String and Binary Flags
+            Borrowed = 0x80, // points into memory owned elsewhere
         };
 
         MappingNode() noexcept : m_type(Type::Null) {}
-        virtual ~MappingNode() noexcept
-        {
-            Clear();
-        }
+        // Not a write: a node destroyed inside a tree goes through a write to its parent
+        virtual ~MappingNode() noexcept = default;
 
-        // Copy constructor
+        // Copy constructor (O(1) for copy-on-write nodes, see SetCopyOnWrite)
         MappingNode(const MappingNode& other) : m_type(Type::Null)
         {
-            try
+            XE_TRY
             {
                 m_type = other.m_type;
+                m_copyOnWrite = other.m_copyOnWrite;
+                m_subtype = other.m_subtype;
                 m_key = other.m_key;
                 m_data = other.m_data;
-                m_children = other.m_children;
-                m_keyMap = other.m_keyMap;
+                m_source = other.m_source;
+                m_hash = other.m_hash.load(std::memory_order_relaxed);
+                if (other.m_copyOnWrite)
+                {
+                    m_children = other.m_children;
+                }
+                else if (other.m_children)
+                {
+                    m_children = std::make_shared<Children>(*other.m_children);
+                }
             }
-            catch (...)
+            XE_CATCH_ALL
             {
                 Clear();
-                throw;
+                XE_RETHROW;
             }
         }
 
         // Move constructor
         MappingNode(MappingNode&& other) noexcept
             : m_type(other.m_type),
+            m_copyOnWrite(other.m_copyOnWrite),
+            m_subtype(other.m_subtype),
             m_key(std::move(other.m_key)),
             m_data(std::move(other.m_data)),
             m_children(std::move(other.m_children)),
-            m_keyMap(std::move(other.m_keyMap))
+            m_source(std::move(other.m_source)),
+            m_hash(other.m_hash.load(std::memory_order_relaxed))
         {
+            if (m_children)
+            {
+                m_children->parent = nullptr;
+            }
+            // Emptying 'other' is a write to the tree it may sit in
             other.m_type = Type::Null;
+            other.Touch();
         }
 
         // Copy assignment
@@ -115,10 +169,18 @@ namespace xe
             {
                 Clear();
                 m_type = other.m_type;
+                m_copyOnWrite = other.m_copyOnWrite;
+                m_subtype = other.m_subtype;
                 m_data = std::move(other.m_data);
                 m_children = std::move(other.m_children);
-                m_keyMap = std::move(other.m_keyMap);
+                m_source = std::move(other.m_source);
+                m_hash = other.m_hash.load(std::memory_order_relaxed);
+                if (m_children)
+                {
+                    m_children->parent = m_parent;
+                }
                 other.m_type = Type::Null;
+                other.Touch();
             }
             return *this;
         }
@@ -126,25 +188,27 @@ namespace xe
         // String assignment
         MappingNode& operator=(std::string_view value)
         {
-            try
+            XE_TRY
             {
+                // 'value' may view this node's own borrowed memory
+                std::shared_ptr<const std::string_view> source = std::move(m_source);
                 Clear();
                 m_type = Type::String;
                 m_data.resize(value.length());
                 std::memcpy(m_data.data(), value.data(), value.length());
                 return *this;
             }
-            catch (...)
+            XE_CATCH_ALL
             {
                 Clear();
-                throw;
+                XE_RETHROW;
             }
         }
 
         // C-string assignment with nullptr check
         MappingNode& operator=(const char* value)
         {
-            if (!value) throw std::invalid_argument("Null string pointer");
+            if (!value) XE_THROW(std::invalid_argument("Null string pointer"));
             return operator=(std::string_view(value));
         }
 
@@ -161,7 +225,7 @@ namespace xe
         std::enable_if_t<std::is_arithmetic_v<T>, MappingNode&>
             operator=(const T& value)
         {
-            try
+            XE_TRY
             {
                 Clear();
                 if constexpr (std::is_same_v<T, bool>)
@@ -173,8 +237,8 @@ namespace xe
                 else if constexpr (std::is_floating_point_v<T>)
                 {
                     // Check if the float is actually a whole number
-                    double intpart;
-                    if (std::modf(static_cast<double>(value), &intpart) == 0.0)
+                    const double intpart = static_cast<double>(value);
+                    if (StoresAsInteger(intpart))
                     {
                         // It's a whole number, store as integer
                         m_type = Type::Numeric;
@@ -242,10 +306,10 @@ namespace xe
                 }
                 return *this;
             }
-            catch (...)
+            XE_CATCH_ALL
             {
                 Clear();
-                throw;
+                XE_RETHROW;
             }
         }
 
@@ -256,20 +320,21 @@ namespace xe
         {
             if (!IsScalar())
             {
-                throw std::runtime_error("Node is not a scalar");
+                XE_THROW(std::runtime_error("Node is not a scalar"));
             }
 
             if constexpr (std::is_base_of_v<std::string, T>)
             {
-                if (m_type != Type::String)
-                {
-                    throw std::runtime_error("Type mismatch: not a string");
-                }
+                std::string_view view = AsStringView();
                 T result;
-                result.resize(m_data.size());
-                std::memcpy(result.data(), m_data.data(), m_data.size());
+                result.resize(view.size());
+                std::memcpy(result.data(), view.data(), view.size());
                 return result;
             }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                return AsStringView();
+            }
             else
             {
                 return AsNumeric<T>();
@@ -283,22 +348,280 @@ namespace xe
             return AsMappable<T>();
         }
 
+        // Never throws on a missing or mismatched value: empty if As<T>() would have thrown
+        template<typename T>
+        std::optional<T> TryAs() const
+        {
+            static_assert(!std::is_base_of_v<IMappable, T>, "TryAs does not support IMappable types");
+
+            if constexpr (std::is_base_of_v<std::string, T> || std::is_same_v<T, std::string_view>)
+            {
+                if (!IsString())
+                {
+                    return std::nullopt;
+                }
+                std::string_view view = AsStringView();
+                return T(view.data(), view.size());
+            }
+            else
+            {
+                if (IsRawNumber())
+                {
+                    return TryParseNumber<T>(RawText());
+                }
+                if (!CanCast<T>())
+                {
+                    return std::nullopt;
+                }
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    if (HasDecimal() && m_data.size() > sizeof(float))
+                    {
+                        double value;
+                        std::memcpy(&value, m_data.data(), sizeof(double));
+                        if (value > std::numeric_limits<float>::max() || value < std::numeric_limits<float>::lowest())
+                        {
+                            return std::nullopt;
+                        }
+                    }
+                }
+                return AsNumeric<T>();
+            }
+        }
+
+        // 'fallback' if the value is missing or of another type
+        template<typename T>
+        T As(const T& fallback) const
+        {
+            std::optional<T> result = TryAs<T>();
+            return (result) ? *result : fallback;
+        }
+
+        // No copy: valid while this node is neither modified nor destroyed
+        std::string_view AsStringView() const
+        {
+            if (!IsString())
+            {
+                XE_THROW(std::runtime_error("Type mismatch: not a string"));
+            }
+            if (IsBorrowed())
+            {
+                return *m_source;
+            }
+            return std::string_view(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+        }
+
+        // String that refers to memory owned elsewhere instead of holding a copy, typically an
+        // aliasing pointer from StringArena::Borrow that keeps the document's arena alive.
+        // Copies of the node borrow the same memory.
+        void SetBorrowedString(std::shared_ptr<const std::string_view> view)
+        {
+            if (!view)
+            {
+                XE_THROW(std::invalid_argument("Null string view"));
+            }
+            Clear();
+            m_type = static_cast<Type>(static_cast<uint8_t>(Type::String) | static_cast<uint8_t>(Type::Borrowed));
+            m_source = std::move(view);
+        }
+
+        bool IsBorrowed() const noexcept
+        {
+            return (IsString() || IsBinary()) && (static_cast<uint8_t>(m_type) & static_cast<uint8_t>(Type::Borrowed));
+        }
+
+        // Bytes kept as they are: images, hashes, packed buffers. BSON reads and writes them as
+        // binary elements, JSON as base64 strings and YAML as !!binary scalars. 'subtype' is the
+        // BSON binary subtype (0 for generic data).
+        void SetBinary(std::vector<uint8_t> bytes, const uint8_t subtype = 0)
+        {
+            Clear();
+            m_type = Type::Binary;
+            m_data = std::move(bytes);
+            m_subtype = subtype;
+        }
+
+        void SetBinary(const void* data, const size_t size, const uint8_t subtype = 0)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            SetBinary(std::vector<uint8_t>(bytes, bytes + size), subtype);
+        }
+
+        // Binary counterpart of SetBorrowedString: a loader hands out views into one buffer it
+        // keeps alive instead of copying each blob
+        void SetBorrowedBinary(std::shared_ptr<const std::string_view> view, const uint8_t subtype = 0)
+        {
+            if (!view)
+            {
+                XE_THROW(std::invalid_argument("Null binary view"));
+            }
+            Clear();
+            m_type = static_cast<Type>(static_cast<uint8_t>(Type::Binary) | static_cast<uint8_t>(Type::Borrowed));
+            m_source = std::move(view);
+            m_subtype = subtype;
+        }
+
+        // No copy: valid while this node is neither modified nor destroyed
+        ByteSpan AsBytes() const
+        {
+            if (!IsBinary())
+            {
+                XE_THROW(std::runtime_error("Type mismatch: not binary"));
+            }
+            if (IsBorrowed())
+            {
+                return ByteSpan(reinterpret_cast<const uint8_t*>(m_source->data()), m_source->size());
+            }
+            return ByteSpan(m_data.data(), m_data.size());
+        }
+
+        uint8_t BinarySubtype() const noexcept
+        {
+            return (IsBinary()) ? m_subtype : 0;
+        }
+
+        // O(1) copy that shares children with this node. Either side copies only the
+        // containers it later mutates, one level at a time, so the other never sees the change.
+        // References into this node taken before the call must not be used to mutate it.
+        MappingNode Share() const
+        {
+            MappingNode result;
+            result.m_type = m_type;
+            result.m_copyOnWrite = m_copyOnWrite;
+            result.m_subtype = m_subtype;
+            result.m_key = m_key;
+            result.m_data = m_data;
+            result.m_children = m_children;
+            result.m_source = m_source;
+            result.m_hash = m_hash.load(std::memory_order_relaxed);
+            return result;
+        }
+
+        // True if this node's children are currently shared with another node
+        bool IsShared() const noexcept
+        {
+            return m_children && m_children.use_count() > 1;
+        }
+
+        // Opt-in persistent mode for this subtree: plain copies and copy assignment behave like
+        // Share(), so copying a whole document is O(1) and a later mutation copies O(depth) nodes.
+        // Children created afterwards through operator[] / PushBack inherit the mode.
+        void SetCopyOnWrite(const bool enabled)
+        {
+            m_copyOnWrite = enabled;
+            if (m_children && !IsPacked())
+            {
+                for (MappingNode& child : Own().nodes)
+                {
+                    child.SetCopyOnWrite(enabled);
+                }
+            }
+        }
+
+        bool IsCopyOnWrite() const noexcept { return m_copyOnWrite; }
+
+        // Numeric kept as the text it was read from (an optional '-', digits, optional fraction
+        // and exponent). Formatters store numbers this way so the ones never read cost no
+        // conversion and the ones never written back round-trip verbatim. Type queries and As<T>()
+        // parse the text on each call; Resolve() converts it in place once.
+        void SetRawNumber(const std::string_view text)
+        {
+            Clear();
+            m_type = static_cast<Type>(static_cast<uint8_t>(Type::Numeric) | static_cast<uint8_t>(Type::Raw));
+            m_data.assign(text.begin(), text.end());
+        }
+
+        bool IsRawNumber() const noexcept
+        {
+            return IsNumeric() && (static_cast<uint8_t>(m_type) & static_cast<uint8_t>(Type::Raw));
+        }
+
+        std::string_view RawNumber() const
+        {
+            if (!IsRawNumber())
+            {
+                XE_THROW(std::runtime_error("Node is not a raw number"));
+            }
+            return std::string_view(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+        }
+
+        // Parses every raw number in this subtree into its binary form
+        void Resolve()
+        {
+            if (IsRawNumber())
+            {
+                MappingNode resolved = Resolved();
+                m_type = resolved.m_type;
+                m_data = std::move(resolved.m_data);
+                return;
+            }
+            if (m_children && !IsPacked())
+            {
+                for (MappingNode& child : Own().nodes)
+                {
+                    child.Resolve();
+                }
+            }
+        }
+
+        // Array of numbers held as one contiguous buffer instead of a node per element, as loaders
+        // build them with IFormatter::SetPackNumericArrays. It reads like any other array: the
+        // first access that needs element nodes (operator[], iteration, mutation) unpacks it,
+        // typing each element as assigning the double would. Size(), Hash(), equality between
+        // packed arrays and PackedValues() work on the buffer.
+        void SetPackedArray(std::vector<double> values)
+        {
+            Clear();
+            m_type = Type::Array;
+            m_children = std::make_shared<Children>();
+            m_children->parent = m_parent;
+            m_children->packed = std::move(values);
+            m_children->isPacked.store(true, std::memory_order_release);
+        }
+
+        bool IsPacked() const noexcept
+        {
+            return IsArray() && m_children && m_children->isPacked.load(std::memory_order_acquire);
+        }
+
+        const std::vector<double>& PackedValues() const
+        {
+            if (!IsPacked())
+            {
+                XE_THROW(std::runtime_error("Node is not a packed array"));
+            }
+            return m_children->packed;
+        }
+
+        // Whole numbers that fit int64_t are stored as integers when a float or double is assigned
+        static bool StoresAsInteger(const double value) noexcept
+        {
+            return value >= -9223372036854775808.0 && value < 9223372036854775808.0 && std::trunc(value) == value;
+        }
+
         // Array operations
         void PushBack(const MappingNode& node)
+        {
+            PushBack(MappingNode(node));
+        }
+
+        // Takes the node as it is: children of a Share()d node stay shared rather than copied
+        void PushBack(MappingNode&& node)
         {
             if (!IsArray())
             {
                 if (IsMapping())
                 {
-                    throw std::runtime_error("Cannot PushBack to a Mapping node");
+                    XE_THROW(std::runtime_error("Cannot PushBack to a Mapping node"));
                 }
                 Clear();
                 m_type = Type::Array;
             }
 
-            MappingNode newNode = node;
-            newNode.m_key.clear();
-            m_children.push_back(std::move(newNode));
+            node.m_key.clear();
+            node.m_copyOnWrite |= m_copyOnWrite;
+            Own().Append(std::move(node));
+            Touch();
         }
 
         template<typename T>
@@ -306,7 +629,84 @@ namespace xe
         {
             MappingNode node;
             node = value;
-            PushBack(node);
+            PushBack(std::move(node));
+        }
+
+        // Inserts before 'index' (index == Size() appends)
+        void Insert(size_t index, const MappingNode& node)
+        {
+            if (!IsArray())
+            {
+                XE_THROW(std::runtime_error("Cannot Insert into a non-Array node"));
+            }
+
+            Children& children = Own();
+            if (index > children.nodes.size())
+            {
+                XE_THROW(std::out_of_range("Insert index out of range"));
+            }
+
+            MappingNode newNode = node;
+            newNode.m_key.clear();
+            newNode.m_copyOnWrite |= m_copyOnWrite;
+            children.Insert(index, std::move(newNode));
+            Touch();
+        }
+
+        // Removes a child of an Array or Mapping; later children shift down
+        void Erase(size_t index)
+        {
+            if (!IsMapping() && !IsArray())
+            {
+                XE_THROW(std::runtime_error("Node is not an array or mapping"));
+            }
+
+            Children& children = Own();
+            if (index >= children.nodes.size())
+            {
+                XE_THROW(std::out_of_range("Erase index out of range"));
+            }
+
+            if (IsArray())
+            {
+                children.nodes.erase(children.nodes.begin() + index);
+                Touch();
+                return;
+            }
+
+            // Rebuilt rather than erased in place: move assignment keeps the target's key
+            std::vector<MappingNode> kept;
+            kept.reserve(children.nodes.size() - 1);
+            children.keyMap.clear();
+            for (size_t i = 0; i < children.nodes.size(); ++i)
+            {
+                if (i != index)
+                {
+                    children.keyMap.emplace(HashString(children.nodes[i].m_key), kept.size());
+                    kept.push_back(std::move(children.nodes[i]));
+                }
+            }
+            children.nodes = std::move(kept);
+            children.Adopt(0);
+            Touch();
+        }
+
+        // Returns false if the key was not present
+        bool Erase(std::string_view key)
+        {
+            if (!IsMapping() || !m_children)
+            {
+                return false;
+            }
+
+            size_t index = IndexOf(key, HashString(key));
+            if (index == s_npos)
+            {
+                return false;
+            }
+
+            Erase(index);
+            return true;
         }
 
         // Access operations with bounds checking
@@ -316,63 +716,128 @@ namespace xe
             {
                 if (IsArray())
                 {
-                    throw std::runtime_error("Cannot use string key with Array node");
+                    XE_THROW(std::runtime_error("Cannot use string key with Array node"));
                 }
                 Clear();
                 m_type = Type::Mapping;
             }
 
-            auto it = m_keyMap.find(std::string(key));
-            if (it != m_keyMap.end())
+            const uint64_t hash = HashString(key);
+            size_t index = IndexOf(key, hash);
+            Children& children = Own();
+            if (index != s_npos)
             {
-                return m_children[it->second];
+                return children.nodes[index];
             }
 
-            m_keyMap[std::string(key)] = m_children.size();
-            m_children.emplace_back();
-            m_children.back().m_key = std::string(key);
-            return m_children.back();
+            MappingNode child;
+            child.m_key = key;
+            child.m_copyOnWrite = m_copyOnWrite;
+            children.keyMap.emplace(hash, children.nodes.size());
+            MappingNode& added = children.Append(std::move(child));
+            Touch();
+            return added;
         }
 
         const MappingNode& operator[](const std::string& key) const
         {
             if (!IsMapping())
             {
-                throw std::runtime_error("Node is not a mapping");
+                XE_THROW(std::runtime_error("Node is not a mapping"));
             }
 
-            auto it = m_keyMap.find(std::string(key));
-            if (it == m_keyMap.end())
+            if (const MappingNode* child = Find(key))
             {
-                static const MappingNode null_node;
-                return null_node;
+                return *child;
             }
 
-            return m_children.at(it->second);
+            static const MappingNode null_node;
+            return null_node;
         }
 
         MappingNode& operator[](size_t index)
         {
             if (!IsMapping() && !IsArray())
             {
-                throw std::runtime_error("Node is not an array or mapping");
+                XE_THROW(std::runtime_error("Node is not an array or mapping"));
             }
-            return m_children.at(index);
+            return Own().nodes.at(index);
         }
 
         const MappingNode& operator[](size_t index) const
         {
             if (!IsMapping() && !IsArray())
             {
-                throw std::runtime_error("Node is not an array or mapping");
+                XE_THROW(std::runtime_error("Node is not an array or mapping"));
             }
-            return m_children.at(index);
+            return Nodes().at(index);
         }
 
         // Query operations
         bool ContainsKey(std::string_view key) const noexcept
         {
-            return IsMapping() && m_keyMap.find(std::string(key)) != m_keyMap.end();
+            return Find(key) != nullptr;
+        }
+
+        // The child under 'key', or null if there is none or this is not a mapping. Never throws
+        // and never allocates.
+        const MappingNode* Find(std::string_view key) const noexcept
+        {
+            if (!IsMapping())
+            {
+                return nullptr;
+            }
+            size_t index = IndexOf(key, HashString(key));
+            return (index != s_npos) ? &m_children->nodes[index] : nullptr;
+        }
+
+        // Same as Find(key) with the hash already known, e.g. Find("speed"_xk)
+        const MappingNode* Find(const xe::Key& key) const noexcept
+        {
+            if (!IsMapping())
+            {
+                return nullptr;
+            }
+            size_t index = IndexOf(key.name, key.hash);
+            return (index != s_npos) ? &m_children->nodes[index] : nullptr;
+        }
+
+        // Walks a precompiled path; null if any step is missing. Never throws and never allocates.
+        const MappingNode* Find(const Path& path) const noexcept
+        {
+            const MappingNode* node = this;
+            for (const Path::Segment& segment : path)
+            {
+                if (node->IsMapping())
+                {
+                    size_t index = node->IndexOf(segment.key, segment.hash);
+                    if (index == s_npos)
+                    {
+                        return nullptr;
+                    }
+                    node = &node->m_children->nodes[index];
+                }
+                else if (node->IsArray() && segment.index < node->Nodes().size())
+                {
+                    node = &node->m_children->nodes[segment.index];
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+            return node;
+        }
+
+        // Like Find(path), but throws if the path does not resolve
+        const MappingNode& At(const Path& path) const
+        {
+            const MappingNode* node = Find(path);
+            if (!node)
+            {
+                XE_THROW(std::runtime_error("Path not found: " + path.ToString()));
+            }
+            return *node;
         }
 
         std::string_view Key() const noexcept
@@ -385,23 +850,42 @@ namespace xe
         {
             m_type = Type::Null;
             m_data.clear();
-            m_children.clear();
-            m_keyMap.clear();
+            m_children.reset();
+            m_source.reset();
+            m_subtype = 0;
+            Touch();
         }
 
         void Trim()
         {
-            for (auto iter = m_children.begin(); iter != m_children.end();)
+            if (!m_children || IsPacked())
+            {
+                return;
+            }
+
+            // Rebuilt rather than erased in place: move assignment keeps the target's key
+            Children& children = Own();
+            std::vector<MappingNode> kept;
+            kept.reserve(children.nodes.size());
+            for (MappingNode& child : children.nodes)
             {
-                if (iter->IsDefined())
+                if (child.IsDefined())
                 {
-                    iter->Trim();
-                    ++iter;
+                    child.Trim();
+                    kept.push_back(std::move(child));
                 }
-                else
+            }
+            children.nodes = std::move(kept);
+            children.Adopt(0);
+            Touch();
+
+            // Positions have shifted, so re-index the keys
+            if (IsMapping())
+            {
+                children.keyMap.clear();
+                for (size_t i = 0; i < children.nodes.size(); ++i)
                 {
-                    m_keyMap.erase(iter->m_key);
-                    iter = m_children.erase(iter);
+                    children.keyMap.emplace(HashString(children.nodes[i].m_key), i);
                 }
             }
         }
@@ -414,8 +898,19 @@ namespace xe
         }
         bool IsArray() const noexcept { return m_type == Type::Array; }
         bool IsMapping() const noexcept { return m_type == Type::Mapping; }
-        bool IsString() const noexcept { return m_type == Type::String; }
+        bool IsString() const noexcept
+        {
+            return (static_cast<uint8_t>(m_type) &
+                ~static_cast<uint8_t>(Type::FlagMask)) ==
+                static_cast<uint8_t>(Type::String);
+        }
         bool IsBoolean() const noexcept { return m_type == Type::Boolean; }
+        bool IsBinary() const noexcept
+        {
+            return (static_cast<uint8_t>(m_type) &
+                ~static_cast<uint8_t>(Type::FlagMask)) ==
+                static_cast<uint8_t>(Type::Binary);
+        }
         bool IsNumeric() const noexcept
         {
             return (static_cast<uint8_t>(m_type) &
@@ -424,11 +919,21 @@ namespace xe
         }
         bool HasDecimal() const noexcept
         {
+            if (IsRawNumber())
+            {
+                MappingNode resolved;
+                return ParseNumber(RawText(), resolved) && resolved.HasDecimal();
+            }
             return IsNumeric() && (static_cast<uint8_t>(m_type) &
                 static_cast<uint8_t>(Type::Decimal));
         }
         bool IsNegative() const noexcept
         {
+            if (IsRawNumber())
+            {
+                MappingNode resolved;
+                return ParseNumber(RawText(), resolved) && resolved.IsNegative();
+            }
             return IsNumeric() && (static_cast<uint8_t>(m_type) &
                 static_cast<uint8_t>(Type::Negative));
         }
@@ -438,7 +943,15 @@ namespace xe
         {
             if (!IsScalar())
             {
-                throw std::runtime_error("Cannot get width of non-scalar type. Use 'Size()' if looking for map or array length.");
+                XE_THROW(std::runtime_error("Cannot get width of non-scalar type. Use 'Size()' if looking for map or array length."));
+            }
+            if (IsRawNumber())
+            {
+                return Resolved().m_data.size();
+            }
+            if (IsBorrowed())
+            {
+                return m_source->size();
             }
             return m_data.size();
         }
@@ -448,36 +961,537 @@ namespace xe
         {
             if (!IsMapping() && !IsArray())
             {
-                throw std::runtime_error("Cannot get width of non-map/array type. Use 'Width()' if looking for data width.");
+                XE_THROW(std::runtime_error("Cannot get width of non-map/array type. Use 'Width()' if looking for data width."));
+            }
+            if (IsPacked())
+            {
+                return m_children->packed.size();
+            }
+            return Nodes().size();
+        }
+
+        // Structural hash of the subtree: values, and the keys of mapping entries (this node's own
+        // key is excluded, and mapping entry order does not matter). Cached per node (per children
+        // block for containers). A write drops the cache of the node written and of each
+        // container above it, found through parent links, however the node was reached; so the
+        // next Hash() after an edit recomputes only the edited path and reuses the rest.
+        uint64_t Hash() const
+        {
+            std::atomic<uint64_t>& cache = (m_children) ? m_children->hash : m_hash;
+            uint64_t hash = cache.load(std::memory_order_relaxed);
+            if (hash == 0)
+            {
+                hash = ComputeHash();
+                hash += (hash == 0);
+                cache.store(hash, std::memory_order_relaxed);
+            }
+            return hash;
+        }
+
+        // Moves on with every write to this node's children or to anything under them, in the
+        // same way the cached hash is dropped. Never repeats for different contents, so an
+        // unchanged value means an unchanged subtree; 0 for a node without children.
+        uint64_t Version() const noexcept
+        {
+            return (m_children) ? m_children->version : 0;
+        }
+
+        // Deep equality. Shared subtrees and differing hashes answer in O(1); matching hashes are
+        // confirmed by a walk, which skips any shared children on the way.
+        bool operator==(const MappingNode& other) const
+        {
+            if (this == &other)
+            {
+                return true;
+            }
+            if (IsRawNumber() || other.IsRawNumber())
+            {
+                return IsNumeric() && other.IsNumeric() && Hash() == other.Hash() &&
+                    NumericBits() == other.NumericBits();
+            }
+            if (IsString() && other.IsString())
+            {
+                return AsStringView() == other.AsStringView();
+            }
+            if (IsBinary() && other.IsBinary())
+            {
+                const ByteSpan bytes = AsBytes();
+                const ByteSpan otherBytes = other.AsBytes();
+                return m_subtype == other.m_subtype && bytes.size() == otherBytes.size() &&
+                    (bytes.empty() || std::memcmp(bytes.data(), otherBytes.data(), bytes.size()) == 0);
+            }
+            if (m_type != other.m_type)
+            {
+                return false;
+            }
+            if (m_children && m_children == other.m_children)
+            {
+                return true;
+            }
+            if (Hash() != other.Hash())
+            {
+                return false;
+            }
+
+            if (IsMapping())
+            {
+                if (Size() != other.Size())
+                {
+                    return false;
+                }
+                for (const MappingNode& child : Nodes())
+                {
+                    const MappingNode* match = other.Find(child.m_key);
+                    if (!match || !(child == *match))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            if (IsArray())
+            {
+                if (IsPacked() && other.IsPacked())
+                {
+                    return m_children->packed == other.m_children->packed;
+                }
+                return Nodes() == other.Nodes();
+            }
+
+            if (IsNumeric())
+            {
+                return NumericBits() == other.NumericBits();
             }
-            return m_children.size();
+            return m_data == other.m_data;
+        }
+
+        bool operator!=(const MappingNode& other) const
+        {
+            return !(*this == other);
         }
 
         // Iterator support
         using iterator = typename std::vector<MappingNode>::iterator;
         using const_iterator = typename std::vector<MappingNode>::const_iterator;
 
-        iterator begin() noexcept { return m_children.begin(); }
-        iterator end() noexcept { return m_children.end(); }
-        const_iterator begin() const noexcept { return m_children.begin(); }
-        const_iterator end() const noexcept { return m_children.end(); }
-        const_iterator cbegin() const noexcept { return m_children.cbegin(); }
-        const_iterator cend() const noexcept { return m_children.cend(); }
+        iterator begin() { return (m_children) ? Own().nodes.begin() : iterator(); }
+        iterator end() { return (m_children) ? Own().nodes.end() : iterator(); }
+        const_iterator begin() const noexcept { return Nodes().begin(); }
+        const_iterator end() const noexcept { return Nodes().end(); }
+        const_iterator cbegin() const noexcept { return Nodes().cbegin(); }
+        const_iterator cend() const noexcept { return Nodes().cend(); }
 
     private:
+        // Keys are indexed by hash so a lookup never builds a std::string; entries that share a
+        // hash are told apart by comparing the child's key
+        struct KeyHash
+        {
+            size_t operator()(const uint64_t hash) const noexcept { return static_cast<size_t>(hash); }
+        };
+
+        struct Children
+        {
+            std::vector<MappingNode> nodes;
+            std::unordered_multimap<uint64_t, size_t, KeyHash> keyMap; // HashString(key) -> index
+
+            // Elements of a packed array; 'nodes' stays empty while isPacked is set
+            std::vector<double> packed;
+            std::atomic<bool> isPacked = false;
+
+            Children* parent = nullptr; // the block holding the node that owns this one
+            mutable std::atomic<uint64_t> hash = 0; // of the owning container, 0 = not computed
+            uint64_t version = NextVersion();
+
+            Children() = default;
+            Children(const Children& other) : keyMap(other.keyMap),
+                hash(other.hash.load(std::memory_order_relaxed)), version(other.version)
+            {
+                if (other.isPacked.load(std::memory_order_acquire))
+                {
+                    packed = other.packed;
+                    isPacked.store(true, std::memory_order_relaxed);
+                }
+                else
+                {
+                    nodes = other.nodes;
+                    Adopt(0);
+                }
+            }
+
+            // Points nodes[from...] (the ones constructed or moved in) back at this block
+            void Adopt(const size_t from) noexcept
+            {
+                for (size_t i = from; i < nodes.size(); ++i)
+                {
+                    nodes[i].m_parent = this;
+                    if (nodes[i].m_children)
+                    {
+                        nodes[i].m_children->parent = this;
+                    }
+                }
+            }
+
+            MappingNode& Append(MappingNode&& node)
+            {
+                const size_t capacity = nodes.capacity();
+                nodes.push_back(std::move(node));
+                Adopt((nodes.capacity() == capacity) ? nodes.size() - 1 : 0);
+                return nodes.back();
+            }
+
+            void Insert(const size_t index, MappingNode&& node)
+            {
+                const size_t capacity = nodes.capacity();
+                nodes.insert(nodes.begin() + index, std::move(node));
+                Adopt((nodes.capacity() == capacity) ? index : 0);
+            }
+
+            // Drops the cached hash of this block and of every block above it
+            void Touch() noexcept
+            {
+                const uint64_t next = NextVersion();
+                for (Children* block = this; block; block = block->parent)
+                {
+                    block->hash.store(0, std::memory_order_relaxed);
+                    block->version = next;
+                }
+            }
+        };
+
+        // Unique across threads without sharing a counter: each thread draws from its own range
+        static uint64_t NextVersion() noexcept
+        {
+            static std::atomic<uint64_t> ranges = 1;
+            thread_local uint64_t next = ranges.fetch_add(1, std::memory_order_relaxed) << 40;
+            return ++next;
+        }
+
+        static constexpr size_t s_npos = static_cast<size_t>(-1);
+
+        size_t IndexOf(const std::string_view key, const uint64_t hash) const noexcept
+        {
+            if (!m_children)
+            {
+                return s_npos;
+            }
+            auto range = m_children->keyMap.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (m_children->nodes[it->second].m_key == key)
+                {
+                    return it->second;
+                }
+            }
+            return s_npos;
+        }
+
+        const std::vector<MappingNode>& Nodes() const noexcept
+        {
+            static const std::vector<MappingNode> empty;
+            if (!m_children)
+            {
+                return empty;
+            }
+            if (m_children->isPacked.load(std::memory_order_acquire))
+            {
+                Unpack(*m_children, m_copyOnWrite);
+            }
+            return m_children->nodes;
+        }
+
+        // Builds the element nodes of a packed array. Const readers may get here from several
+        // threads at once, so it runs under a lock and publishes through isPacked; the buffer is
+        // kept for readers still holding PackedValues() and released by the next Own().
+        static void Unpack(Children& children, const bool copyOnWrite)
+        {
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!children.isPacked.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            children.nodes.resize(children.packed.size());
+            for (size_t i = 0; i < children.packed.size(); ++i)
+            {
+                children.nodes[i] = children.packed[i];
+                children.nodes[i].m_copyOnWrite = copyOnWrite;
+            }
+            children.Adopt(0);
+            children.isPacked.store(false, std::memory_order_release);
+        }
+
+        // Called after every write to this node: drops its cached hash and those of the containers
+        // above it, which costs the depth of the node and nothing elsewhere
+        void Touch() noexcept
+        {
+            m_hash.store(0, std::memory_order_relaxed);
+            if (m_children)
+            {
+                m_children->Touch();
+            }
+            else if (m_parent)
+            {
+                m_parent->Touch();
+            }
+        }
+
+        // Children for writing; copies them first (one level, grandchildren stay shared) if shared.
+        // Not a write by itself: callers that change the children call Touch().
+        Children& Own()
+        {
+            if (!m_children)
+            {
+                m_children = std::make_shared<Children>();
+            }
+            else if (m_children.use_count() > 1)
+            {
+                std::shared_ptr<Children> copy = std::make_shared<Children>();
+                if (m_children->isPacked.load(std::memory_order_acquire))
+                {
+                    copy->packed = m_children->packed;
+                    copy->isPacked.store(true, std::memory_order_relaxed);
+                }
+                else
+                {
+                    copy->nodes.reserve(m_children->nodes.size());
+                    for (const MappingNode& child : m_children->nodes)
+                    {
+                        copy->nodes.push_back(child.Share());
+                    }
+                    copy->Adopt(0);
+                }
+                copy->keyMap = m_children->keyMap;
+                copy->hash.store(m_children->hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                copy->version = m_children->version;
+                m_children = std::move(copy);
+            }
+            m_children->parent = m_parent;
+
+            // About to be written element by element
+            if (m_children->isPacked.load(std::memory_order_relaxed))
+            {
+                Unpack(*m_children, m_copyOnWrite);
+            }
+            if (!m_children->packed.empty())
+            {
+                std::vector<double>().swap(m_children->packed);
+            }
+            return *m_children;
+        }
+
+        static uint64_t Mix(uint64_t value) noexcept
+        {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ull;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebull;
+            return value ^ (value >> 31);
+        }
+
+        // Width-independent bits of a numeric value, so 5 stored as uint8_t or int64_t compare equal
+        uint64_t NumericBits() const
+        {
+            if (IsRawNumber())
+            {
+                return Resolved().NumericBits();
+            }
+            if (HasDecimal())
+            {
+                double value = AsFloatingPoint<double>();
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                return bits;
+            }
+            return (IsNegative()) ? static_cast<uint64_t>(AsInteger<int64_t>()) : AsInteger<uint64_t>();
+        }
+
+        uint64_t ComputeHash() const
+        {
+            if (IsRawNumber())
+            {
+                return Resolved().ComputeHash();
+            }
+
+            uint64_t hash = Mix(static_cast<uint64_t>(m_type) + 1);
+            if (IsMapping())
+            {
+                // Order-independent: entries are summed
+                uint64_t sum = 0;
+                for (const MappingNode& child : Nodes())
+                {
+                    sum += Mix(HashString(child.m_key) ^ child.Hash());
+                }
+                return Mix(hash ^ sum);
+            }
+            if (IsArray())
+            {
+                if (IsPacked())
+                {
+                    // Each element hashed as the node it unpacks to, without keeping the node
+                    MappingNode element;
+                    for (const double value : m_children->packed)
+                    {
+                        element = value;
+                        hash = Mix(hash ^ element.ComputeHash());
+                    }
+                    return hash;
+                }
+                for (const MappingNode& child : Nodes())
+                {
+                    hash = Mix(hash ^ child.Hash());
+                }
+                return hash;
+            }
+            if (IsNumeric())
+            {
+                return Mix(hash ^ NumericBits());
+            }
+            if (IsString())
+            {
+                // Borrowed or not
+                std::string_view view = AsStringView();
+                return HashBytes(view.data(), view.size(), Mix(static_cast<uint64_t>(Type::String) + 1));
+            }
+            if (IsBinary())
+            {
+                const ByteSpan bytes = AsBytes();
+                return HashBytes(bytes.data(), bytes.size(), Mix((static_cast<uint64_t>(Type::Binary) + 1) ^ (static_cast<uint64_t>(m_subtype) << 8)));
+            }
+            return HashBytes(m_data.data(), m_data.size(), hash);
+        }
+
+        std::string_view RawText() const noexcept
+        {
+            return std::string_view(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+        }
+
+        // Gives raw text the type the formatters gave numbers when they converted eagerly:
+        // integers in the smallest of 32/64 bits, decimals as float when that is exact
+        static bool ParseNumber(const std::string_view text, MappingNode& out) noexcept
+        {
+            if (text.find_first_of(".eE") == std::string_view::npos)
+            {
+                if (!text.empty() && text[0] == '-')
+                {
+                    int64_t value;
+                    if (!NumberFormat::Parse(text, value))
+                        return false;
+                    if (value >= std::numeric_limits<int32_t>::min())
+                        out = static_cast<int32_t>(value);
+                    else
+                        out = value;
+                    return true;
+                }
+
+                uint64_t value;
+                if (!NumberFormat::Parse(text, value))
+                    return false;
+                if (value <= std::numeric_limits<uint32_t>::max())
+                    out = static_cast<uint32_t>(value);
+                else
+                    out = value;
+                return true;
+            }
+
+            double value;
+            if (!NumberFormat::Parse(text, value))
+                return false;
+            if (static_cast<double>(static_cast<float>(value)) == value)
+                out = static_cast<float>(value);
+            else
+                out = value;
+            return true;
+        }
+
+        // TryAs<T>() of the node ParseNumber() would build, without building it
+        template<typename T>
+        static std::optional<T> TryParseNumber(const std::string_view text) noexcept
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                return std::nullopt;
+            }
+            else if (text.find_first_of(".eE") == std::string_view::npos)
+            {
+                const bool negative = !text.empty() && text[0] == '-';
+                uint64_t bits;
+                if (negative)
+                {
+                    int64_t value;
+                    if (!NumberFormat::Parse(text, value))
+                        return std::nullopt;
+                    bits = static_cast<uint64_t>(value);
+                }
+                else if (!NumberFormat::Parse(text, bits))
+                {
+                    return std::nullopt;
+                }
+
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    // ParseNumber() keeps what does not fit 32 bits in 64, which float refuses
+                    const bool wide = negative
+                        ? static_cast<int64_t>(bits) < std::numeric_limits<int32_t>::min()
+                        : bits > std::numeric_limits<uint32_t>::max();
+                    if (wide && sizeof(T) < sizeof(int64_t))
+                        return std::nullopt;
+                    return negative ? static_cast<T>(static_cast<int64_t>(bits)) : static_cast<T>(bits);
+                }
+                else
+                {
+                    if (!IntegerFits<T>(negative, bits))
+                        return std::nullopt;
+                    return negative ? static_cast<T>(static_cast<int64_t>(bits)) : static_cast<T>(bits);
+                }
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                double value;
+                if (!NumberFormat::Parse(text, value))
+                    return std::nullopt;
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    if (value > std::numeric_limits<float>::max() || value < std::numeric_limits<float>::lowest())
+                        return std::nullopt;
+                }
+                return static_cast<T>(value);
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+
+        MappingNode Resolved() const
+        {
+            MappingNode result;
+            if (!ParseNumber(RawText(), result))
+            {
+                XE_THROW(std::runtime_error("Bad numeric text: " + std::string(RawText())));
+            }
+            return result;
+        }
+
         template<typename T>
         T AsNumeric() const
         {
+            if (IsRawNumber())
+            {
+                return Resolved().AsNumeric<T>();
+            }
+
             if (!CanCast<T>())
             {
-                throw std::runtime_error("Invalid numeric cast");
+                XE_THROW(std::runtime_error("Invalid numeric cast"));
             }
 
             if constexpr (std::is_same_v<T, bool>)
             {
                 if (!IsBoolean())
                 {
-                    throw std::runtime_error("Node is not a boolean");
+                    XE_THROW(std::runtime_error("Node is not a boolean"));
                 }
                 T result;
                 std::memcpy(&result, m_data.data(), sizeof(T));
@@ -518,7 +1532,7 @@ namespace xe
                             return static_cast<T>(temp);
                         }
                         default:
-                            throw std::runtime_error("Invalid integer size");
+                            XE_THROW(std::runtime_error("Invalid integer size"));
                     }
                 }
                 else
@@ -546,7 +1560,7 @@ namespace xe
                             return static_cast<T>(temp);
                         }
                         default:
-                            throw std::runtime_error("Invalid integer size");
+                            XE_THROW(std::runtime_error("Invalid integer size"));
                     }
                 }
             }
@@ -582,7 +1596,7 @@ namespace xe
                     if (value > std::numeric_limits<float>::max() ||
                         value < std::numeric_limits<float>::lowest())
                     {
-                        throw std::runtime_error("Value exceeds float capacity");
+                        XE_THROW(std::runtime_error("Value exceeds float capacity"));
                     }
                     return static_cast<float>(value);
                 }
@@ -604,12 +1618,12 @@ namespace xe
         {
             if (HasDecimal())
             {
-                throw std::runtime_error("Cannot convert decimal to integer");
+                XE_THROW(std::runtime_error("Cannot convert decimal to integer"));
             }
 
             if (IsNegative() && std::is_unsigned_v<T>)
             {
-                throw std::runtime_error("Cannot convert negative to unsigned");
+                XE_THROW(std::runtime_error("Cannot convert negative to unsigned"));
             }
 
             // Handle sign extension for signed integers
@@ -639,7 +1653,7 @@ namespace xe
                         return static_cast<T>(temp);
                     }
                     default:
-                        throw std::runtime_error("Invalid integer size");
+                        XE_THROW(std::runtime_error("Invalid integer size"));
                 }
             }
             else
@@ -666,12 +1680,12 @@ namespace xe
                         uint64_t temp;
                         std::memcpy(&temp, m_data.data(), sizeof(uint64_t));
                         if (std::is_signed_v<T> && temp > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
-                            throw std::runtime_error("Integer overflow");
+                            XE_THROW(std::runtime_error("Integer overflow"));
                         }
                         return static_cast<T>(temp);
                     }
                     default:
-                        throw std::runtime_error("Invalid integer size");
+                        XE_THROW(std::runtime_error("Invalid integer size"));
                 }
             }
         }
@@ -704,14 +1718,93 @@ namespace xe
                 return false;
             }
 
-            return m_data.size() <= sizeof(T);
+            if constexpr (std::is_integral_v<T>)
+            {
+                // By value, so a small int64_t still reads as uint8_t and a large uint64_t never as int64_t
+                return IntegerFits<T>(IsNegative(), IntegerBits());
+            }
+            else
+            {
+                return m_data.size() <= sizeof(T);
+            }
+        }
+
+        // The stored integer widened to 64 bits, sign-extended when negative
+        uint64_t IntegerBits() const noexcept
+        {
+            if (IsNegative())
+            {
+                switch (m_data.size())
+                {
+                    case sizeof(int8_t) : {
+                        int8_t temp;
+                        std::memcpy(&temp, m_data.data(), sizeof(int8_t));
+                        return static_cast<uint64_t>(static_cast<int64_t>(temp));
+                    }
+                    case sizeof(int16_t) : {
+                        int16_t temp;
+                        std::memcpy(&temp, m_data.data(), sizeof(int16_t));
+                        return static_cast<uint64_t>(static_cast<int64_t>(temp));
+                    }
+                    case sizeof(int32_t) : {
+                        int32_t temp;
+                        std::memcpy(&temp, m_data.data(), sizeof(int32_t));
+                        return static_cast<uint64_t>(static_cast<int64_t>(temp));
+                    }
+                    default: {
+                        int64_t temp = 0;
+                        std::memcpy(&temp, m_data.data(), std::min(m_data.size(), sizeof(int64_t)));
+                        return static_cast<uint64_t>(temp);
+                    }
+                }
+            }
+
+            switch (m_data.size())
+            {
+                case sizeof(uint8_t) : {
+                    uint8_t temp;
+                    std::memcpy(&temp, m_data.data(), sizeof(uint8_t));
+                    return temp;
+                }
+                case sizeof(uint16_t) : {
+                    uint16_t temp;
+                    std::memcpy(&temp, m_data.data(), sizeof(uint16_t));
+                    return temp;
+                }
+                case sizeof(uint32_t) : {
+                    uint32_t temp;
+                    std::memcpy(&temp, m_data.data(), sizeof(uint32_t));
+                    return temp;
+                }
+                default: {
+                    uint64_t temp = 0;
+                    std::memcpy(&temp, m_data.data(), std::min(m_data.size(), sizeof(uint64_t)));
+                    return temp;
+                }
+            }
+        }
+
+        // Whether an integer (as IntegerBits() gives it) converts to T without changing value
+        template<typename T>
+        static bool IntegerFits(const bool negative, const uint64_t bits) noexcept
+        {
+            if (negative)
+            {
+                return std::is_signed_v<T>
+                    && static_cast<int64_t>(bits) >= static_cast<int64_t>(std::numeric_limits<T>::min());
+            }
+            return bits <= static_cast<uint64_t>(std::numeric_limits<T>::max());
         }
 
         Type m_type;
+        bool m_copyOnWrite = false;
+        uint8_t m_subtype = 0; // of a binary node
         std::string m_key;
         std::vector<uint8_t> m_data;
-        std::vector<MappingNode> m_children;
-        std::unordered_map<std::string, size_t> m_keyMap;
+        std::shared_ptr<Children> m_children;
+        std::shared_ptr<const std::string_view> m_source; // a borrowed string or binary
+        mutable std::atomic<uint64_t> m_hash = 0; // 0 = not computed; containers use Children::hash
+        Children* m_parent = nullptr; // the block this node is an element of, if any
     };
 }
 
@@ -0,0 +1,370 @@
+/*========================================================
+
+ XEMarkup - NumberFormat
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_NUMBERFORMAT_H
+#define XE_NUMBERFORMAT_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace xe
+{
+    // Number <-> text for the text formatters. Integers are written two digits at a time from a
+    // pair table; decimals use std::to_chars' shortest round-trip digits, laid out as json::dump
+    // lays out doubles ("1.0", "0.0001", "1e-05", "1.5e+20"). Parsing goes through
+    // std::from_chars, after an exact fast path for short doubles. Writing a value and parsing
+    // the text back as the same type is bit-exact.
+    class NumberFormat
+    {
+    public:
+        // Enough for any integer up to 64 bits and any float or double
+        static constexpr size_t s_maxChars = 32;
+
+        // Writes 'value' at 'out' and returns the end. No terminator is written.
+        template<typename T>
+        static char* Write(char* out, const T value) noexcept
+        {
+            static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "NumberFormat writes numbers only");
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return WriteDecimal(out, value);
+            }
+            else
+            {
+                using Unsigned = std::make_unsigned_t<T>;
+                Unsigned magnitude = static_cast<Unsigned>(value);
+                if constexpr (std::is_signed_v<T>)
+                {
+                    if (value < 0)
+                    {
+                        *out++ = '-';
+                        magnitude = static_cast<Unsigned>(0 - magnitude);
+                    }
+                }
+
+                if constexpr (sizeof(T) <= sizeof(uint32_t))
+                    return WriteDigits(out, static_cast<uint32_t>(magnitude));
+                else
+                    return WriteDigits(out, static_cast<uint64_t>(magnitude));
+            }
+        }
+
+        template<typename T>
+        static void Append(std::string& out, const T value)
+        {
+            char buffer[s_maxChars];
+            out.append(buffer, Write(buffer, value));
+        }
+
+        template<typename T>
+        static std::string ToString(const T value)
+        {
+            std::string result;
+            Append(result, value);
+            return result;
+        }
+
+        // Fails unless the whole text is one number that fits T. Accepts what std::from_chars
+        // does: no leading '+' or whitespace.
+        template<typename T>
+        static bool Parse(const std::string_view text, T& out) noexcept
+        {
+            static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "NumberFormat parses numbers only");
+            if constexpr (std::is_same_v<T, double>)
+            {
+                if (ParseShort(text, out))
+                    return true;
+            }
+            const char* last = text.data() + text.size();
+            auto result = std::from_chars(text.data(), last, out);
+            return result.ec == std::errc() && result.ptr == last;
+        }
+
+        // Parse as double, failing for integer text that a double cannot hold exactly (2^53 on)
+        static bool ParseExactDouble(const std::string_view text, double& out) noexcept
+        {
+            if (!Parse(text, out))
+                return false;
+            return std::fabs(out) < 9007199254740992.0 || text.find_first_of(".eE") != std::string_view::npos;
+        }
+
+    private:
+        // Clinger's fast path: when the significant digits fit in 53 bits and the power of ten is
+        // at most 10^22, both are exact doubles and one multiply or divide rounds correctly.
+        // Anything else (or anything malformed) is left to std::from_chars.
+        static bool ParseShort(const std::string_view text, double& out) noexcept
+        {
+            static constexpr double powers[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+            const char* pos = text.data();
+            const char* end = pos + text.size();
+            const bool negative = (pos < end && *pos == '-');
+            pos += negative;
+
+            uint64_t mantissa = 0;
+            int digits = 0;
+            const char* whole = pos;
+            pos = ReadDigits(text.data(), pos, end, mantissa, digits);
+            int exponent = 0;
+            if (pos < end && *pos == '.')
+            {
+                const char* fraction = ++pos;
+                pos = ReadDigits(text.data(), pos, end, mantissa, digits);
+                if (pos == fraction)
+                    return false;
+                exponent = -static_cast<int>(pos - fraction);
+            }
+            else if (pos == whole)
+            {
+                return false;
+            }
+
+            if (pos < end && (*pos == 'e' || *pos == 'E'))
+            {
+                ++pos;
+                const bool negativeExponent = (pos < end && *pos == '-');
+                pos += (pos < end && (*pos == '-' || *pos == '+'));
+                int value = 0;
+                const char* first = pos;
+                for (; pos < end && pos - first < 4 && static_cast<unsigned>(*pos - '0') < 10; ++pos)
+                {
+                    value = value * 10 + (*pos - '0');
+                }
+                if (pos == first)
+                    return false;
+                exponent += (negativeExponent) ? -value : value;
+            }
+
+            if (pos != end || digits > 19 || mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+                return false;
+
+            double value = static_cast<double>(mantissa);
+            value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+            out = (negative) ? -value : value;
+            return true;
+        }
+
+        // Accumulates the run of decimal digits at 'pos' into 'value', up to eight at a time: the
+        // run is found from a byte mask and converted with three multiplies. Near the end of the
+        // text the eight bytes ending at 'end' are loaded instead, so 'first' must be 8 or more
+        // bytes back for that. Past 19 digits only the count keeps growing.
+        static const char* ReadDigits(const char* first, const char* pos, const char* end, uint64_t& value, int& count) noexcept
+        {
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            static constexpr uint64_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+            while (end - first >= 8 && pos < end && count <= 11)
+            {
+                const size_t available = static_cast<size_t>(end - pos);
+                uint64_t chunk;
+                if (available >= 8)
+                {
+                    std::memcpy(&chunk, pos, 8);
+                }
+                else
+                {
+                    // Bytes past the end come in as zero, which is not a digit
+                    std::memcpy(&chunk, end - 8, 8);
+                    chunk >>= 8 * (8 - available);
+                }
+
+                // High bit set in every non-digit byte; the lowest one is exact, which is all
+                // that is used
+                const uint64_t stops = ((chunk + 0x4646464646464646ull) | (chunk - 0x3030303030303030ull)) & 0x8080808080808080ull;
+                const int length = (stops) ? LowestByte(stops) : 8;
+                if (length == 0)
+                    break;
+
+                // The run moved to the top bytes with '0' below, then pairs, quads and the
+                // eight-digit value (first digit in the lowest byte)
+                if (length < 8)
+                    chunk = (chunk << (8 * (8 - length))) | (0x3030303030303030ull >> (8 * length));
+                chunk -= 0x3030303030303030ull;
+                chunk = (chunk * 10) + (chunk >> 8);
+                chunk = (((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+                    (((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+                value = value * scales[length] + chunk;
+                pos += length;
+                count += length;
+                if (length < 8)
+                    return pos;
+            }
+#endif
+            for (; pos < end && static_cast<unsigned>(*pos - '0') < 10; ++pos, ++count)
+            {
+                if (count < 19)
+                    value = value * 10 + static_cast<unsigned>(*pos - '0');
+            }
+            return pos;
+        }
+
+        // Index of the lowest nonzero byte
+        static int LowestByte(const uint64_t mask) noexcept
+        {
+#ifdef _MSC_VER
+            unsigned long bit;
+            _BitScanForward64(&bit, mask);
+            return static_cast<int>(bit / 8);
+#else
+            return __builtin_ctzll(mask) / 8;
+#endif
+        }
+
+        static constexpr char s_digitPairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        // Decimal point positions (relative to the first digit) that are written without an exponent
+        static constexpr int s_minPoint = -3;
+        static constexpr int s_maxPoint = 15;
+
+        template<typename U>
+        static char* WriteDigits(char* out, U value) noexcept
+        {
+            char buffer[20];
+            char* pos = buffer + sizeof(buffer);
+            while (value >= 100)
+            {
+                pos -= 2;
+                std::memcpy(pos, s_digitPairs + (value % 100) * 2, 2);
+                value /= 100;
+            }
+            if (value >= 10)
+            {
+                pos -= 2;
+                std::memcpy(pos, s_digitPairs + value * 2, 2);
+            }
+            else
+            {
+                *--pos = static_cast<char>('0' + value);
+            }
+
+            const size_t length = static_cast<size_t>(buffer + sizeof(buffer) - pos);
+            std::memcpy(out, pos, length);
+            return out + length;
+        }
+
+        // Infinities and NaN come out as std::to_chars spells them; callers that need another
+        // spelling check std::isfinite first
+        template<typename F>
+        static char* WriteDecimal(char* out, const F value) noexcept
+        {
+            if (!std::isfinite(value))
+            {
+                return std::to_chars(out, out + s_maxChars, value).ptr;
+            }
+            if (std::signbit(value))
+            {
+                *out++ = '-';
+            }
+            if (value == 0)
+            {
+                std::memcpy(out, "0.0", 3);
+                return out + 3;
+            }
+
+            // Shortest digits as d[.ddd]e[+-]x, split into the digits and the exponent
+            char text[s_maxChars];
+            const char* end = std::to_chars(text, text + sizeof(text), std::fabs(value), std::chars_format::scientific).ptr;
+            char digits[s_maxChars];
+            int length = 0;
+            const char* pos = text;
+            for (; *pos != 'e'; ++pos)
+            {
+                if (*pos != '.')
+                    digits[length++] = *pos;
+            }
+            const bool negativeExponent = (*++pos == '-');
+            int exponent = 0;
+            for (++pos; pos < end; ++pos)
+            {
+                exponent = exponent * 10 + (*pos - '0');
+            }
+            if (negativeExponent)
+            {
+                exponent = -exponent;
+            }
+
+            // value = 0.digits * 10^point
+            const int point = exponent + 1;
+            if (length <= point && point <= s_maxPoint)
+            {
+                // digits[000].0
+                std::memcpy(out, digits, length);
+                std::memset(out + length, '0', point - length);
+                out += point;
+                std::memcpy(out, ".0", 2);
+                return out + 2;
+            }
+            if (0 < point && point <= s_maxPoint)
+            {
+                // dig.its
+                std::memcpy(out, digits, point);
+                out[point] = '.';
+                std::memcpy(out + point + 1, digits + point, length - point);
+                return out + length + 1;
+            }
+            if (s_minPoint <= point && point <= 0)
+            {
+                // 0.[000]digits
+                std::memcpy(out, "0.", 2);
+                std::memset(out + 2, '0', -point);
+                std::memcpy(out + 2 - point, digits, length);
+                return out + 2 - point + length;
+            }
+
+            // d[.igits]e+XX, at least two exponent digits as printf("%g") writes them
+            *out++ = digits[0];
+            if (length > 1)
+            {
+                *out++ = '.';
+                std::memcpy(out, digits + 1, length - 1);
+                out += length - 1;
+            }
+            *out++ = 'e';
+            *out++ = (exponent < 0) ? '-' : '+';
+            const int magnitude = (exponent < 0) ? -exponent : exponent;
+            if (magnitude >= 100)
+            {
+                *out++ = static_cast<char>('0' + magnitude / 100);
+            }
+            std::memcpy(out, s_digitPairs + (magnitude % 100) * 2, 2);
+            return out + 2;
+        }
+    };
+}
+
+#endif // !XE_NUMBERFORMAT_H
\ No newline at end of file
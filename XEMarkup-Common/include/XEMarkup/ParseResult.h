@@ -0,0 +1,84 @@
+/*========================================================
+
+ XEMarkup - ParseResult
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_PARSERESULT_H
+#define XE_PARSERESULT_H
+
+#include "MappingNode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace xe
+{
+    struct ParseError
+    {
+        enum class Code : uint8_t
+        {
+            None,
+            Syntax, // malformed input
+            OutOfRange, // a number or length the format cannot hold
+            FileAccess, // the file could not be read
+            Other,
+        };
+
+        Code code = Code::None;
+        size_t offset = 0; // byte offset of the error in the input
+        size_t line = 0; // 1-based; 0 when unknown
+        size_t column = 0; // 1-based; 0 when unknown
+        std::string path; // JSON Pointer (RFC 6901) to the value being read, where the formatter tracks it
+        std::string message;
+
+        // Sets offset, and line and column from it, for text input
+        void Locate(const std::string_view content, size_t errorOffset)
+        {
+            offset = errorOffset = (errorOffset < content.size()) ? errorOffset : content.size();
+            line = 1;
+            size_t lineStart = 0;
+            for (size_t i = 0; i < errorOffset; ++i)
+            {
+                if (content[i] == '\n')
+                {
+                    ++line;
+                    lineStart = i + 1;
+                }
+            }
+            column = errorOffset - lineStart + 1;
+        }
+    };
+
+    // What the non-throwing IFormatter::TryLoad* functions return: the tree, or why there is none
+    struct ParseResult
+    {
+        MappingNode node;
+        ParseError error;
+
+        bool Ok() const noexcept { return error.code == ParseError::Code::None; }
+        explicit operator bool() const noexcept { return Ok(); }
+    };
+}
+
+#endif // !XE_PARSERESULT_H
\ No newline at end of file
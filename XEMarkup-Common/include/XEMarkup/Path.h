@@ -0,0 +1,188 @@
+/*========================================================
+
+ XEMarkup - Path
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_PATH_H
+#define XE_PATH_H
+
+#include "Exceptions.h"
+#include "Hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xe
+{
+    // A mapping key with its hash worked out up front. "name"_xk builds one at compile time.
+    struct Key
+    {
+        std::string_view name;
+        uint64_t hash;
+
+        constexpr explicit Key(const std::string_view name) noexcept : name(name), hash(HashString(name)) {}
+    };
+
+    inline namespace literals
+    {
+        constexpr Key operator""_xk(const char* str, const size_t size) noexcept
+        {
+            return Key(std::string_view(str, size));
+        }
+    }
+
+    // A sequence of keys and array indices compiled once (from a JSON Pointer such as
+    // "/player/position/x" or from a key list) so MappingNode::Find / At can walk it every frame
+    // without hashing or allocating. A segment made only of digits also addresses an array
+    // element when the node it reaches is an array.
+    class Path
+    {
+    public:
+        struct Segment
+        {
+            std::string key;
+            uint64_t hash;
+            size_t index; // s_noIndex unless the key is a plain decimal number
+        };
+
+        static constexpr size_t s_noIndex = static_cast<size_t>(-1);
+
+        Path() = default;
+
+        // Parses a JSON Pointer (RFC 6901); "" is the root
+        explicit Path(const std::string_view pointer)
+        {
+            for (std::string& key : SplitPointer(pointer))
+                Append(std::move(key));
+        }
+
+        Path(const std::initializer_list<Key> keys)
+        {
+            m_segments.reserve(keys.size());
+            for (const Key& key : keys)
+                Append(std::string(key.name));
+        }
+
+        explicit Path(const std::vector<std::string>& keys)
+        {
+            m_segments.reserve(keys.size());
+            for (const std::string& key : keys)
+                Append(key);
+        }
+
+        Path& Append(std::string key)
+        {
+            const uint64_t hash = HashString(key);
+            const size_t index = ParseIndex(key);
+            m_segments.push_back({ std::move(key), hash, index });
+            return *this;
+        }
+
+        Path& Append(const size_t index)
+        {
+            return Append(std::to_string(index));
+        }
+
+        size_t Size() const noexcept { return m_segments.size(); }
+        bool Empty() const noexcept { return m_segments.empty(); }
+        const Segment& operator[](const size_t i) const { return m_segments[i]; }
+
+        std::vector<Segment>::const_iterator begin() const noexcept { return m_segments.begin(); }
+        std::vector<Segment>::const_iterator end() const noexcept { return m_segments.end(); }
+
+        // Back to JSON Pointer form
+        std::string ToString() const
+        {
+            std::string result;
+            for (const Segment& segment : m_segments)
+                AppendToken(result, segment.key);
+            return result;
+        }
+
+        // Appends '/' and 'key' as a JSON Pointer token: '~' becomes "~0" and '/' becomes "~1"
+        static void AppendToken(std::string& pointer, const std::string_view key)
+        {
+            pointer += '/';
+            for (char c : key)
+            {
+                if (c == '~') pointer += "~0";
+                else if (c == '/') pointer += "~1";
+                else pointer += c;
+            }
+        }
+
+        // The unescaped tokens of a JSON Pointer; "" gives none. Throws unless it starts with '/'.
+        static std::vector<std::string> SplitPointer(const std::string_view pointer)
+        {
+            std::vector<std::string> tokens;
+            if (pointer.empty())
+                return tokens;
+            if (pointer[0] != '/')
+                XE_THROW(std::runtime_error("Invalid path: " + std::string(pointer)));
+
+            for (size_t start = 1; start <= pointer.size();)
+            {
+                size_t end = pointer.find('/', start);
+                if (end == std::string_view::npos)
+                    end = pointer.size();
+
+                std::string token;
+                for (size_t i = start; i < end; ++i)
+                {
+                    if (pointer[i] == '~' && i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1'))
+                    {
+                        token += (pointer[++i] == '0') ? '~' : '/';
+                        continue;
+                    }
+                    token += pointer[i];
+                }
+                tokens.push_back(std::move(token));
+                start = end + 1;
+            }
+            return tokens;
+        }
+
+    private:
+        static size_t ParseIndex(const std::string_view key) noexcept
+        {
+            if (key.empty() || key.size() > 18)
+                return s_noIndex;
+            size_t index = 0;
+            for (char c : key)
+            {
+                if (c < '0' || c > '9')
+                    return s_noIndex;
+                index = index * 10 + static_cast<size_t>(c - '0');
+            }
+            return index;
+        }
+
+        std::vector<Segment> m_segments;
+    };
+}
+
+#endif // !XE_PATH_H
\ No newline at end of file
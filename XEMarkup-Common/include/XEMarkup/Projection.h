@@ -0,0 +1,281 @@
+/*========================================================
+
+ XEMarkup - Projection
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_PROJECTION_H
+#define XE_PROJECTION_H
+
+#include "Hash.h"
+#include "MappingNode.h"
+#include "Path.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace xe
+{
+    // Selects the parts of a document a load should keep: either a set of JSON Pointers
+    // (a "*" segment matches any key or index) or a predicate over the pointer of each value.
+    // The result keeps the mappings on the way down to what was selected; arrays on the way
+    // keep only the elements that lead somewhere, in order, so their indices close up.
+    class Projection
+    {
+    public:
+        enum class Decision : uint8_t
+        {
+            Skip,    // leave the value out
+            Descend, // build the container but decide for each child
+            Keep,    // keep the whole value
+        };
+
+        // Called with the JSON Pointer of each value ("" for the root) the parser reaches
+        using Predicate = std::function<Decision(std::string_view path)>;
+
+        // Keeps everything
+        Projection() = default;
+
+        Projection(const std::initializer_list<std::string_view> paths)
+        {
+            for (std::string_view path : paths)
+                Add(path);
+        }
+
+        explicit Projection(const std::vector<std::string>& paths)
+        {
+            for (const std::string& path : paths)
+                Add(path);
+        }
+
+        explicit Projection(Predicate predicate) : m_predicate(std::move(predicate)) {}
+
+        bool KeepsAll() const noexcept
+        {
+            return !m_predicate && (m_nodes.empty() || m_nodes[0].keep);
+        }
+
+        // Prunes a tree that is already loaded. Kept subtrees are shared with 'node', not copied.
+        MappingNode Apply(const MappingNode& node) const
+        {
+            Walker walker(*this);
+            MappingNode result;
+            switch (walker.Root())
+            {
+            case Decision::Keep:
+                result = node.Share();
+                break;
+            case Decision::Descend:
+                Prune(walker, node, result);
+                break;
+            case Decision::Skip:
+                break;
+            }
+            return result;
+        }
+
+        // Where a parser is in the document. Call Root() for the top-level value and Enter()
+        // for each child of a container that was given Descend, with its key or source index.
+        // Enter() only moves down when it returns Descend; Leave() moves back up once that
+        // container closes (or straight away if the value turned out not to be a container).
+        class Walker
+        {
+        public:
+            explicit Walker(const Projection& projection) : m_projection(projection)
+            {
+                if (!m_projection.m_predicate && !m_projection.m_nodes.empty())
+                {
+                    m_frames.push_back(0);
+                    m_states.push_back(0);
+                }
+            }
+
+            Decision Root() const
+            {
+                if (m_projection.m_predicate)
+                    return m_projection.m_predicate(std::string_view());
+                return m_projection.KeepsAll() ? Decision::Keep : Decision::Descend;
+            }
+
+            Decision Enter(const std::string_view key)
+            {
+                if (m_projection.m_predicate)
+                {
+                    m_pathLengths.push_back(m_path.size());
+                    Path::AppendToken(m_path, key);
+
+                    Decision decision = m_projection.m_predicate(m_path);
+                    if (decision != Decision::Descend)
+                    {
+                        m_path.resize(m_pathLengths.back());
+                        m_pathLengths.pop_back();
+                    }
+                    return decision;
+                }
+
+                // Every trie node reachable at this depth (more than one only with wildcards)
+                const size_t begin = m_frames.back();
+                const size_t end = m_states.size();
+                const uint64_t hash = HashString(key);
+                bool keep = false;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    for (const Edge& edge : m_projection.m_nodes[m_states[i]].edges)
+                    {
+                        if (!edge.wildcard && (edge.hash != hash || edge.key != key))
+                            continue;
+
+                        const TrieNode& target = m_projection.m_nodes[edge.target];
+                        keep |= target.keep;
+                        if (!target.edges.empty())
+                            m_states.push_back(edge.target);
+                    }
+                }
+
+                if (keep || m_states.size() == end)
+                {
+                    m_states.resize(end);
+                    return keep ? Decision::Keep : Decision::Skip;
+                }
+                m_frames.push_back(end);
+                return Decision::Descend;
+            }
+
+            Decision Enter(const size_t index)
+            {
+                char buffer[24];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), index);
+                return Enter(std::string_view(buffer, static_cast<size_t>(result.ptr - buffer)));
+            }
+
+            void Leave()
+            {
+                if (m_projection.m_predicate)
+                {
+                    m_path.resize(m_pathLengths.back());
+                    m_pathLengths.pop_back();
+                    return;
+                }
+                m_states.resize(m_frames.back());
+                m_frames.pop_back();
+            }
+
+        private:
+            const Projection& m_projection;
+            std::vector<size_t> m_states; // trie nodes per level, flattened
+            std::vector<size_t> m_frames; // where each level starts in m_states
+            std::string m_path; // predicate mode
+            std::vector<size_t> m_pathLengths;
+        };
+
+    private:
+        struct Edge
+        {
+            std::string key;
+            uint64_t hash;
+            bool wildcard;
+            size_t target;
+        };
+
+        struct TrieNode
+        {
+            bool keep = false;
+            std::vector<Edge> edges;
+        };
+
+        void Add(const std::string_view pointer)
+        {
+            if (m_nodes.empty())
+                m_nodes.emplace_back();
+
+            size_t node = 0;
+            for (const Path::Segment& segment : Path(pointer))
+            {
+                if (m_nodes[node].keep)
+                    return; // already kept whole
+
+                size_t next = 0;
+                for (const Edge& edge : m_nodes[node].edges)
+                {
+                    if (edge.key == segment.key)
+                    {
+                        next = edge.target;
+                        break;
+                    }
+                }
+                if (next == 0)
+                {
+                    next = m_nodes.size();
+                    m_nodes[node].edges.push_back({ segment.key, segment.hash, segment.key == "*", next });
+                    m_nodes.emplace_back();
+                }
+                node = next;
+            }
+
+            m_nodes[node].keep = true;
+            m_nodes[node].edges.clear();
+        }
+
+        static void Prune(Walker& walker, const MappingNode& in, MappingNode& out)
+        {
+            if (!in.IsMapping() && !in.IsArray())
+                return;
+
+            size_t index = 0;
+            for (const MappingNode& child : in)
+            {
+                const Decision decision = (in.IsMapping()) ? walker.Enter(child.Key()) : walker.Enter(index++);
+                if (decision == Decision::Skip)
+                    continue;
+
+                MappingNode result;
+                if (decision == Decision::Keep)
+                {
+                    result = child.Share();
+                }
+                else
+                {
+                    Prune(walker, child, result);
+                    walker.Leave();
+                    if (!result.IsDefined())
+                        continue;
+                }
+
+                if (in.IsMapping())
+                    out[std::string(child.Key())] = std::move(result);
+                else
+                    out.PushBack(std::move(result));
+            }
+        }
+
+        std::vector<TrieNode> m_nodes; // [0] is the root; empty keeps everything
+        Predicate m_predicate;
+    };
+}
+
+#endif // !XE_PROJECTION_H
\ No newline at end of file
@@ -0,0 +1,567 @@
+/*========================================================
+
+ XEMarkup - Query
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_QUERY_H
+#define XE_QUERY_H
+
+#include "Exceptions.h"
+#include "MappingNode.h"
+#include "Path.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xe
+{
+    // A compiled JSONPath expression. Supported:
+    //   $                 root (optional)
+    //   .name  ['name']   child by key
+    //   .*  [*]           every child of a mapping or array
+    //   ..name  ..*  ..[] recursive descent
+    //   [0]  [-1]  [0,2]  array indices and unions (names may be mixed in)
+    //   [1:5]  [::2]      slices with Python semantics
+    //   [?(@.hp < 50 && @.tag == 'boss')]
+    //                     children for which the filter holds; comparisons are == != < <= > >=
+    //                     against a number, 'string', true, false or null, a bare @.path tests
+    //                     existence, and && binds tighter than ||
+    // Compile once and run against any number of documents. Matches are pointers into the
+    // document, which must outlive them.
+    class Query
+    {
+    public:
+        Query() = default;
+
+        explicit Query(const std::string_view expression) : m_expression(expression)
+        {
+            Parser parser{ m_expression, 0 };
+            parser.Root(m_steps);
+        }
+
+        const std::string& Expression() const noexcept { return m_expression; }
+
+        // Calls visit(const MappingNode&) for every match in document order
+        template<typename Visitor>
+        void ForEach(const MappingNode& root, Visitor&& visit) const
+        {
+            Apply(0, root, visit);
+        }
+
+        std::vector<const MappingNode*> Select(const MappingNode& root) const
+        {
+            std::vector<const MappingNode*> result;
+            ForEach(root, [&result](const MappingNode& match) { result.push_back(&match); });
+            return result;
+        }
+
+    private:
+        struct Comparison
+        {
+            enum class Op : uint8_t { Exists, Eq, Ne, Lt, Le, Gt, Ge };
+            enum class Literal : uint8_t { None, Number, String, Boolean, Null };
+
+            Path path; // relative to @
+            Op op = Op::Exists;
+            Literal literal = Literal::None;
+            double number = 0.0;
+            std::string string;
+            bool boolean = false;
+        };
+
+        struct Selector
+        {
+            enum class Kind : uint8_t { Name, Wildcard, Index, Slice, Filter };
+
+            Kind kind = Kind::Name;
+            Path name; // a single segment, hashed once here
+            long long start = 0, end = 0, step = 1;
+            bool hasStart = false, hasEnd = false;
+            std::vector<std::vector<Comparison>> filter; // OR of ANDs
+        };
+
+        struct Step
+        {
+            bool recursive = false;
+            std::vector<Selector> selectors;
+        };
+
+        template<typename Visitor>
+        void Apply(const size_t stepIndex, const MappingNode& node, Visitor& visit) const
+        {
+            if (stepIndex == m_steps.size())
+            {
+                visit(node);
+                return;
+            }
+
+            const Step& step = m_steps[stepIndex];
+            for (const Selector& selector : step.selectors)
+            {
+                Match(selector, node, [&](const MappingNode& match) { Apply(stepIndex + 1, match, visit); });
+            }
+
+            if (step.recursive && (node.IsMapping() || node.IsArray()))
+            {
+                for (const MappingNode& child : node)
+                {
+                    Apply(stepIndex, child, visit);
+                }
+            }
+        }
+
+        template<typename Visitor>
+        static void Match(const Selector& selector, const MappingNode& node, const Visitor& visit)
+        {
+            switch (selector.kind)
+            {
+            case Selector::Kind::Name:
+                if (node.IsMapping())
+                {
+                    if (const MappingNode* child = node.Find(selector.name))
+                        visit(*child);
+                }
+                return;
+
+            case Selector::Kind::Wildcard:
+                if (node.IsMapping() || node.IsArray())
+                {
+                    for (const MappingNode& child : node)
+                        visit(child);
+                }
+                return;
+
+            case Selector::Kind::Index:
+            {
+                if (!node.IsArray())
+                    return;
+                const long long size = static_cast<long long>(node.Size());
+                const long long index = (selector.start < 0) ? selector.start + size : selector.start;
+                if (index >= 0 && index < size)
+                    visit(node[static_cast<size_t>(index)]);
+                return;
+            }
+
+            case Selector::Kind::Slice:
+            {
+                if (!node.IsArray())
+                    return;
+                const long long size = static_cast<long long>(node.Size());
+                auto clamp = [size](long long value, long long low, long long high)
+                {
+                    if (value < 0) value += size;
+                    return (value < low) ? low : (value > high) ? high : value;
+                };
+                if (selector.step > 0)
+                {
+                    long long i = selector.hasStart ? clamp(selector.start, 0, size) : 0;
+                    long long end = selector.hasEnd ? clamp(selector.end, 0, size) : size;
+                    for (; i < end; i += selector.step)
+                        visit(node[static_cast<size_t>(i)]);
+                }
+                else
+                {
+                    long long i = selector.hasStart ? clamp(selector.start, -1, size - 1) : size - 1;
+                    long long end = selector.hasEnd ? clamp(selector.end, -1, size - 1) : -1;
+                    for (; i > end; i += selector.step)
+                        visit(node[static_cast<size_t>(i)]);
+                }
+                return;
+            }
+
+            case Selector::Kind::Filter:
+                if (node.IsMapping() || node.IsArray())
+                {
+                    for (const MappingNode& child : node)
+                    {
+                        if (Test(selector.filter, child))
+                            visit(child);
+                    }
+                }
+                return;
+            }
+        }
+
+        static bool Test(const std::vector<std::vector<Comparison>>& filter, const MappingNode& item)
+        {
+            for (const std::vector<Comparison>& all : filter)
+            {
+                bool holds = true;
+                for (const Comparison& comparison : all)
+                {
+                    if (!Test(comparison, item))
+                    {
+                        holds = false;
+                        break;
+                    }
+                }
+                if (holds)
+                    return true;
+            }
+            return false;
+        }
+
+        static bool Test(const Comparison& comparison, const MappingNode& item)
+        {
+            using Op = Comparison::Op;
+
+            const MappingNode* value = item.Find(comparison.path);
+            if (!value)
+                return false;
+            if (comparison.op == Op::Exists)
+                return true;
+
+            // -1, 0, 1, or 2 when the two sides are not of the same kind
+            int order = 2;
+            switch (comparison.literal)
+            {
+            case Comparison::Literal::Number:
+                if (value->IsNumeric())
+                {
+                    if (std::optional<double> number = value->TryAs<double>())
+                        order = (*number < comparison.number) ? -1 : (*number > comparison.number) ? 1 : 0;
+                }
+                break;
+            case Comparison::Literal::String:
+                if (value->IsString())
+                {
+                    int result = value->AsStringView().compare(comparison.string);
+                    order = (result < 0) ? -1 : (result > 0) ? 1 : 0;
+                }
+                break;
+            case Comparison::Literal::Boolean:
+                if (value->IsBoolean())
+                    order = (value->As<bool>() == comparison.boolean) ? 0 : 2;
+                break;
+            case Comparison::Literal::Null:
+                if (!value->IsDefined())
+                    order = 0;
+                break;
+            case Comparison::Literal::None:
+                break;
+            }
+
+            switch (comparison.op)
+            {
+            case Op::Eq: return order == 0;
+            case Op::Ne: return order != 0;
+            case Op::Lt: return order == -1;
+            case Op::Le: return order == -1 || order == 0;
+            case Op::Gt: return order == 1;
+            case Op::Ge: return order == 1 || order == 0;
+            default: return false;
+            }
+        }
+
+        struct Parser
+        {
+            std::string_view text;
+            size_t pos;
+
+            void Root(std::vector<Step>& steps)
+            {
+                SkipSpace();
+                if (Peek() == '$')
+                    ++pos;
+
+                while (SkipSpace(), pos < text.size())
+                {
+                    Step step;
+                    if (Consume(".."))
+                    {
+                        step.recursive = true;
+                        if (Peek() == '[')
+                            Bracket(step);
+                        else
+                            Dotted(step);
+                    }
+                    else if (Consume("."))
+                    {
+                        Dotted(step);
+                    }
+                    else if (Peek() == '[')
+                    {
+                        Bracket(step);
+                    }
+                    else
+                    {
+                        Fail("unexpected character");
+                    }
+                    steps.push_back(std::move(step));
+                }
+            }
+
+            void Dotted(Step& step)
+            {
+                Selector selector;
+                if (Consume("*"))
+                {
+                    selector.kind = Selector::Kind::Wildcard;
+                }
+                else
+                {
+                    selector.name.Append(std::string(Name()));
+                }
+                step.selectors.push_back(std::move(selector));
+            }
+
+            void Bracket(Step& step)
+            {
+                Expect("[");
+                SkipSpace();
+                if (Consume("?"))
+                {
+                    Selector selector;
+                    selector.kind = Selector::Kind::Filter;
+                    SkipSpace();
+                    if (Consume("("))
+                    {
+                        Filter(selector.filter);
+                        SkipSpace();
+                        Expect(")");
+                    }
+                    else
+                    {
+                        Filter(selector.filter);
+                    }
+                    step.selectors.push_back(std::move(selector));
+                    SkipSpace();
+                    Expect("]");
+                    return;
+                }
+
+                do
+                {
+                    SkipSpace();
+                    step.selectors.push_back(BracketSelector());
+                    SkipSpace();
+                } while (Consume(","));
+                Expect("]");
+            }
+
+            Selector BracketSelector()
+            {
+                Selector selector;
+                if (Consume("*"))
+                {
+                    selector.kind = Selector::Kind::Wildcard;
+                    return selector;
+                }
+                if (Peek() == '\'' || Peek() == '"')
+                {
+                    selector.name.Append(Quoted());
+                    return selector;
+                }
+
+                selector.kind = Selector::Kind::Index;
+                selector.hasStart = Integer(selector.start);
+                SkipSpace();
+                if (!Consume(":"))
+                {
+                    if (!selector.hasStart)
+                        Fail("expected an index");
+                    return selector;
+                }
+
+                selector.kind = Selector::Kind::Slice;
+                SkipSpace();
+                selector.hasEnd = Integer(selector.end);
+                SkipSpace();
+                if (Consume(":"))
+                {
+                    SkipSpace();
+                    if (Integer(selector.step) && selector.step == 0)
+                        Fail("slice step cannot be 0");
+                }
+                return selector;
+            }
+
+            // a && b || c: a list of alternatives, each a list of comparisons that must all hold
+            void Filter(std::vector<std::vector<Comparison>>& filter)
+            {
+                do
+                {
+                    filter.emplace_back();
+                    do
+                    {
+                        SkipSpace();
+                        filter.back().push_back(Compare());
+                        SkipSpace();
+                    } while (Consume("&&"));
+                } while (Consume("||"));
+            }
+
+            Comparison Compare()
+            {
+                using Op = Comparison::Op;
+
+                Comparison comparison;
+                Expect("@");
+                while (true)
+                {
+                    if (Consume("."))
+                    {
+                        comparison.path.Append(std::string(Name()));
+                    }
+                    else if (Peek() == '[')
+                    {
+                        ++pos;
+                        SkipSpace();
+                        long long index = 0;
+                        if (Peek() == '\'' || Peek() == '"')
+                            comparison.path.Append(Quoted());
+                        else if (Integer(index) && index >= 0)
+                            comparison.path.Append(static_cast<size_t>(index));
+                        else
+                            Fail("expected a key or index");
+                        SkipSpace();
+                        Expect("]");
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                SkipSpace();
+                if (Consume("==")) comparison.op = Op::Eq;
+                else if (Consume("!=")) comparison.op = Op::Ne;
+                else if (Consume("<=")) comparison.op = Op::Le;
+                else if (Consume(">=")) comparison.op = Op::Ge;
+                else if (Consume("<")) comparison.op = Op::Lt;
+                else if (Consume(">")) comparison.op = Op::Gt;
+                else return comparison;
+
+                SkipSpace();
+                if (Peek() == '\'' || Peek() == '"')
+                {
+                    comparison.literal = Comparison::Literal::String;
+                    comparison.string = Quoted();
+                }
+                else if (Consume("true"))
+                {
+                    comparison.literal = Comparison::Literal::Boolean;
+                    comparison.boolean = true;
+                }
+                else if (Consume("false"))
+                {
+                    comparison.literal = Comparison::Literal::Boolean;
+                }
+                else if (Consume("null"))
+                {
+                    comparison.literal = Comparison::Literal::Null;
+                }
+                else
+                {
+                    comparison.literal = Comparison::Literal::Number;
+                    const char* begin = text.data() + pos;
+                    if (Peek() == '+')
+                        ++begin;
+                    auto result = std::from_chars(begin, text.data() + text.size(), comparison.number);
+                    if (result.ec != std::errc())
+                        Fail("expected a literal");
+                    pos = static_cast<size_t>(result.ptr - text.data());
+                }
+                return comparison;
+            }
+
+            std::string_view Name()
+            {
+                size_t start = pos;
+                while (pos < text.size() && text[pos] != '.' && text[pos] != '[' && text[pos] != ']' &&
+                    text[pos] != ' ' && text[pos] != ')' && text[pos] != '=' && text[pos] != '!' &&
+                    text[pos] != '<' && text[pos] != '>' && text[pos] != '&' && text[pos] != '|')
+                {
+                    ++pos;
+                }
+                if (pos == start)
+                    Fail("expected a name");
+                return text.substr(start, pos - start);
+            }
+
+            std::string Quoted()
+            {
+                const char quote = text[pos++];
+                std::string result;
+                while (pos < text.size() && text[pos] != quote)
+                {
+                    if (text[pos] == '\\' && pos + 1 < text.size())
+                        ++pos;
+                    result += text[pos++];
+                }
+                Expect(std::string_view(&quote, 1));
+                return result;
+            }
+
+            // False (and nothing consumed) if there is no integer here
+            bool Integer(long long& value)
+            {
+                auto result = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+                if (result.ec != std::errc())
+                    return false;
+                pos = static_cast<size_t>(result.ptr - text.data());
+                return true;
+            }
+
+            char Peek() const noexcept
+            {
+                return (pos < text.size()) ? text[pos] : '\0';
+            }
+
+            void SkipSpace() noexcept
+            {
+                while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+                    ++pos;
+            }
+
+            bool Consume(const std::string_view token) noexcept
+            {
+                if (text.substr(pos, token.size()) != token)
+                    return false;
+                pos += token.size();
+                return true;
+            }
+
+            void Expect(const std::string_view token)
+            {
+                if (!Consume(token))
+                    Fail("expected '" + std::string(token) + "'");
+            }
+
+            [[noreturn]] void Fail(const std::string& reason) const
+            {
+                XE_THROW(std::runtime_error("Invalid query at " + std::to_string(pos) + " (" + reason + "): " + std::string(text)));
+            }
+        };
+
+        std::string m_expression;
+        std::vector<Step> m_steps;
+    };
+}
+
+#endif // !XE_QUERY_H
\ No newline at end of file
@@ -0,0 +1,149 @@
+/*========================================================
+
+ XEMarkup - SharedDocument
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_SHAREDDOCUMENT_H
+#define XE_SHAREDDOCUMENT_H
+
+#include "MappingNode.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace xe
+{
+    // Holds an immutable MappingNode that many threads read while one thread replaces it.
+    // Readers never lock: they pin the current epoch in a per-thread-striped counter and load
+    // the tree pointer. Publish swaps the pointer, advances the epoch and frees the old tree
+    // once every reader pinned to the previous epoch has let go.
+    class SharedDocument
+    {
+    public:
+        class ReadHandle
+        {
+        public:
+            ReadHandle(ReadHandle&& other) noexcept : m_node(other.m_node), m_pin(other.m_pin)
+            {
+                other.m_pin = nullptr;
+            }
+
+            ~ReadHandle()
+            {
+                if (m_pin) m_pin->fetch_sub(1, std::memory_order_release);
+            }
+
+            ReadHandle(const ReadHandle&) = delete;
+            ReadHandle& operator=(const ReadHandle&) = delete;
+            ReadHandle& operator=(ReadHandle&&) = delete;
+
+            const MappingNode& operator*() const noexcept { return *m_node; }
+            const MappingNode* operator->() const noexcept { return m_node; }
+            const MappingNode& Get() const noexcept { return *m_node; }
+
+        private:
+            friend class SharedDocument;
+            ReadHandle(const MappingNode* node, std::atomic<uint32_t>* pin) : m_node(node), m_pin(pin) {}
+
+            const MappingNode* m_node;
+            std::atomic<uint32_t>* m_pin;
+        };
+
+        SharedDocument() : m_current(new MappingNode()) {}
+        explicit SharedDocument(MappingNode node) : m_current(new MappingNode(std::move(node))) {}
+
+        // All ReadHandles must be released first
+        ~SharedDocument()
+        {
+            delete m_current.load();
+        }
+
+        SharedDocument(const SharedDocument&) = delete;
+        SharedDocument& operator=(const SharedDocument&) = delete;
+
+        // Keep handles short-lived: Publish waits for handles taken before it to be released.
+        // Use Snapshot() to hold on to a tree for longer.
+        ReadHandle Read() const
+        {
+            static thread_local const size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % s_stripes;
+
+            while (true)
+            {
+                uint32_t epoch = m_epoch.load();
+                std::atomic<uint32_t>& pin = m_readers[stripe].count[epoch & 1];
+                pin.fetch_add(1);
+
+                // A publish may have retired this epoch between the load and the pin; retry then
+                if (m_epoch.load() == epoch)
+                {
+                    return ReadHandle(m_current.load(), &pin);
+                }
+                pin.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // O(1) copy of the current tree that stays valid across later publishes
+        MappingNode Snapshot() const
+        {
+            ReadHandle handle = Read();
+            return handle->Share();
+        }
+
+        // Swaps in a new tree and returns once the old one has been destroyed
+        void Publish(MappingNode node)
+        {
+            MappingNode* next = new MappingNode(std::move(node));
+
+            std::lock_guard<std::mutex> lock(m_publishMutex);
+            MappingNode* previous = m_current.exchange(next);
+            uint32_t epoch = m_epoch.fetch_add(1);
+
+            for (const Stripe& reader : m_readers)
+            {
+                while (reader.count[epoch & 1].load(std::memory_order_acquire) != 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            delete previous;
+        }
+
+    private:
+        static constexpr size_t s_stripes = 64;
+
+        struct alignas(64) Stripe
+        {
+            std::atomic<uint32_t> count[2] = { 0, 0 };
+        };
+
+        std::atomic<MappingNode*> m_current;
+        std::atomic<uint32_t> m_epoch = 0;
+        mutable std::array<Stripe, s_stripes> m_readers;
+        std::mutex m_publishMutex;
+    };
+}
+
+#endif // !XE_SHAREDDOCUMENT_H
\ No newline at end of file
@@ -0,0 +1,119 @@
+/*========================================================
+
+ XEMarkup - StringArena
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_STRINGARENA_H
+#define XE_STRINGARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <vector>
+
+namespace xe
+{
+    // Append-only storage for the strings of one parsed document. Each stored string is laid
+    // out as a std::string_view header followed by its bytes, and borrowed string nodes
+    // (MappingNode::SetBorrowedString) hold an aliasing pointer to that header which shares
+    // ownership of the arena. A load then allocates once per chunk, not once per string.
+    class StringArena
+    {
+    public:
+        StringArena() = default;
+
+        StringArena(const StringArena&) = delete;
+        StringArena& operator=(const StringArena&) = delete;
+
+        // Copies 'str' in; the returned view lives as long as the arena
+        const std::string_view* Store(const std::string_view str)
+        {
+            char* block = Allocate(sizeof(std::string_view) + Align(str.size()));
+            char* bytes = block + sizeof(std::string_view);
+            std::memcpy(bytes, str.data(), str.size());
+            return new (block) std::string_view(bytes, str.size());
+        }
+
+        // Stores 'str' and returns a pointer to it that keeps 'arena' alive
+        static std::shared_ptr<const std::string_view> Borrow(const std::shared_ptr<StringArena>& arena, const std::string_view str)
+        {
+            return std::shared_ptr<const std::string_view>(arena, arena->Store(str));
+        }
+
+        // Takes ownership of a whole input buffer, so a loader can hand out views into it with
+        // Refer instead of copying each string out. The bytes do not move.
+        const uint8_t* Adopt(std::vector<uint8_t> bytes)
+        {
+            m_adopted.push_back(std::move(bytes));
+            return m_adopted.back().data();
+        }
+
+        // Stores only a view of 'str', which must lie in memory the arena already owns
+        const std::string_view* Refer(const std::string_view str)
+        {
+            return new (Allocate(sizeof(std::string_view))) std::string_view(str);
+        }
+
+        static std::shared_ptr<const std::string_view> BorrowReferred(const std::shared_ptr<StringArena>& arena, const std::string_view str)
+        {
+            return std::shared_ptr<const std::string_view>(arena, arena->Refer(str));
+        }
+
+    private:
+        static constexpr size_t s_chunkSize = 64 * 1024;
+
+        char* Allocate(const size_t size)
+        {
+            if (size > s_chunkSize / 4)
+            {
+                // Large strings get their own block so they do not waste the rest of a chunk
+                m_chunks.push_back(std::make_unique<char[]>(size));
+                return m_chunks.back().get();
+            }
+
+            if (m_current == nullptr || m_used + size > s_chunkSize)
+            {
+                m_chunks.push_back(std::make_unique<char[]>(s_chunkSize));
+                m_current = m_chunks.back().get();
+                m_used = 0;
+            }
+            char* block = m_current + m_used;
+            m_used += size;
+            return block;
+        }
+
+        static constexpr size_t Align(const size_t size)
+        {
+            return (size + alignof(std::string_view) - 1) & ~(alignof(std::string_view) - 1);
+        }
+
+        std::vector<std::unique_ptr<char[]>> m_chunks; // new[] storage is suitably aligned
+        char* m_current = nullptr;
+        size_t m_used = 0;
+        std::vector<std::vector<uint8_t>> m_adopted;
+    };
+}
+
+#endif // !XE_STRINGARENA_H
\ No newline at end of file
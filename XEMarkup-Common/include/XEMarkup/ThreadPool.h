@@ -0,0 +1,175 @@
+/*========================================================
+
+ XEMarkup - ThreadPool
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_THREADPOOL_H
+#define XE_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xe
+{
+    // Work-stealing pool: each worker owns a deque, pops its own work from the back
+    // and steals from the front of the others when it runs dry.
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        explicit ThreadPool(size_t threadCount = 0)
+        {
+            if (threadCount == 0)
+            {
+                threadCount = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            m_queues.reserve(threadCount);
+            for (size_t i = 0; i < threadCount; ++i)
+            {
+                m_queues.push_back(std::make_unique<Queue>());
+            }
+
+            m_threads.reserve(threadCount);
+            for (size_t i = 0; i < threadCount; ++i)
+            {
+                m_threads.emplace_back([this, i]() { Run(i); });
+            }
+        }
+
+        // Finishes all queued work before joining
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_waitMutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+
+            for (std::thread& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void Submit(Task task)
+        {
+            // Work spawned from a worker stays local to it; outside work is spread round-robin
+            size_t index = (t_owner == this) ? t_index : m_nextQueue++ % m_queues.size();
+            {
+                std::lock_guard<std::mutex> lock(m_waitMutex);
+                ++m_pending;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+                m_queues[index]->tasks.push_back(std::move(task));
+            }
+            m_wake.notify_one();
+        }
+
+        size_t ThreadCount() const noexcept { return m_threads.size(); }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void Run(const size_t index)
+        {
+            t_owner = this;
+            t_index = index;
+
+            Task task;
+            while (true)
+            {
+                if (TryPop(index, task))
+                {
+                    task();
+                    task = nullptr;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_waitMutex);
+                m_wake.wait(lock, [this]() { return m_stopping || m_pending > 0; });
+                if (m_stopping && m_pending == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        bool TryPop(const size_t index, Task& out_task)
+        {
+            {
+                Queue& own = *m_queues[index];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty())
+                {
+                    out_task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    --m_pending;
+                    return true;
+                }
+            }
+
+            for (size_t i = 1; i < m_queues.size(); ++i)
+            {
+                Queue& victim = *m_queues[(index + i) % m_queues.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty())
+                {
+                    out_task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    --m_pending;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline static thread_local ThreadPool* t_owner = nullptr;
+        inline static thread_local size_t t_index = 0;
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::atomic<size_t> m_nextQueue = 0;
+        std::atomic<size_t> m_pending = 0;
+        std::mutex m_waitMutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+    };
+}
+
+#endif // !XE_THREADPOOL_H
\ No newline at end of file
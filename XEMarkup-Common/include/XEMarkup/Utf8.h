@@ -0,0 +1,398 @@
+/*========================================================
+
+ XEMarkup - Utf8
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_UTF8_H
+#define XE_UTF8_H
+
+#include "CPUFeatures.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace xe
+{
+    // UTF-8 validation as RFC 3629 defines it: no overlong forms, no surrogates, nothing past
+    // U+10FFFF. The vector paths check 64 bytes per step, skipping blocks of plain ASCII. Other
+    // blocks go through three nibble-indexed table lookups per byte, after Keiser and Lemire,
+    // "Validating UTF-8 In Less Than One Instruction Per Byte". Path::Auto picks the widest path
+    // the CPU supports, once.
+    class Utf8
+    {
+    public:
+        enum class Path : uint8_t
+        {
+            Auto,
+            Scalar,
+            SSE4,
+            AVX2,
+            NEON,
+        };
+
+        static bool IsValid(const char* data, const size_t size, Path path = Path::Auto)
+        {
+            static const Path best = BestPath();
+            if (path == Path::Auto || !Available(path))
+                path = best;
+
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+            switch (path)
+            {
+#ifdef XE_SIMD_X86
+            case Path::AVX2: return IsValidAVX2(bytes, size);
+            case Path::SSE4: return IsValidSSE4(bytes, size);
+#endif
+#ifdef XE_SIMD_NEON
+            case Path::NEON: return IsValidNEON(bytes, size);
+#endif
+            default: return FindInvalid(data, size) == size;
+            }
+        }
+
+        static bool IsValid(const std::string_view text, const Path path = Path::Auto)
+        {
+            return IsValid(text.data(), text.size(), path);
+        }
+
+        // Offset of the first sequence that is not well formed, or 'size'. A byte at a time
+        // outside of ASCII, so meant for locating an error IsValid has found.
+        static size_t FindInvalid(const char* data, const size_t size) noexcept
+        {
+            const std::string_view text(data, size);
+            size_t i = 0;
+            while (i < size)
+            {
+                if (i + 8 <= size)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, data + i, sizeof(word));
+                    if ((word & 0x8080808080808080ull) == 0)
+                    {
+                        i += 8;
+                        continue;
+                    }
+                }
+
+                const size_t length = SequenceLength(text, i);
+                if (length == 0)
+                    return i;
+                i += length;
+            }
+            return size;
+        }
+
+        // Length of the well-formed sequence at 'at', or 0
+        static size_t SequenceLength(const std::string_view text, const size_t at) noexcept
+        {
+            const uint8_t c = static_cast<uint8_t>(text[at]);
+            uint8_t low = 0x80;
+            uint8_t high = 0xBF;
+            size_t length;
+            if (c < 0x80) return 1;
+            else if (c >= 0xC2 && c <= 0xDF) length = 2;
+            else if (c == 0xE0) { length = 3; low = 0xA0; } // no overlong forms
+            else if (c == 0xED) { length = 3; high = 0x9F; } // no surrogates
+            else if (c >= 0xE1 && c <= 0xEF) length = 3;
+            else if (c == 0xF0) { length = 4; low = 0x90; }
+            else if (c == 0xF4) { length = 4; high = 0x8F; } // nothing past U+10FFFF
+            else if (c >= 0xF1 && c <= 0xF3) length = 4;
+            else return 0;
+
+            if (at + length > text.size())
+                return 0;
+            for (size_t i = at + 1; i < at + length; ++i)
+            {
+                const uint8_t next = static_cast<uint8_t>(text[i]);
+                if (next < low || next > high)
+                    return 0;
+                low = 0x80;
+                high = 0xBF;
+            }
+            return length;
+        }
+
+        // The path Path::Auto resolves to on this machine
+        static Path BestPath()
+        {
+            for (const Path path : { Path::AVX2, Path::NEON, Path::SSE4 })
+            {
+                if (Available(path))
+                    return path;
+            }
+            return Path::Scalar;
+        }
+
+    private:
+        // What a pair of bytes can be wrong with. A flag set in all three lookups (first byte's
+        // high nibble, its low nibble, second byte's high nibble) marks an error.
+        static constexpr uint8_t s_tooShort = 1 << 0; // lead byte, then a lead or ASCII byte
+        static constexpr uint8_t s_tooLong = 1 << 1; // ASCII, then a continuation
+        static constexpr uint8_t s_overlong3 = 1 << 2; // E0 80..9F
+        static constexpr uint8_t s_tooLarge = 1 << 3; // F4 90..BF, F5..FF
+        static constexpr uint8_t s_surrogate = 1 << 4; // ED A0..BF
+        static constexpr uint8_t s_overlong2 = 1 << 5; // C0, C1
+        static constexpr uint8_t s_tooLarge1000 = 1 << 6; // F5..FF 80..8F
+        static constexpr uint8_t s_overlong4 = 1 << 6; // F0 80..8F
+        static constexpr uint8_t s_twoConts = 1 << 7; // a continuation, then a continuation
+        static constexpr uint8_t s_carry = s_tooShort | s_tooLong | s_twoConts; // any low nibble
+
+        static constexpr uint8_t s_firstHigh[16] = {
+            s_tooLong, s_tooLong, s_tooLong, s_tooLong, s_tooLong, s_tooLong, s_tooLong, s_tooLong,
+            s_twoConts, s_twoConts, s_twoConts, s_twoConts,
+            s_tooShort | s_overlong2,
+            s_tooShort,
+            s_tooShort | s_overlong3 | s_surrogate,
+            s_tooShort | s_tooLarge | s_tooLarge1000 | s_overlong4,
+        };
+        static constexpr uint8_t s_firstLow[16] = {
+            s_carry | s_overlong3 | s_overlong2 | s_overlong4,
+            s_carry | s_overlong2,
+            s_carry,
+            s_carry,
+            s_carry | s_tooLarge,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000 | s_surrogate,
+            s_carry | s_tooLarge | s_tooLarge1000,
+            s_carry | s_tooLarge | s_tooLarge1000,
+        };
+        static constexpr uint8_t s_secondHigh[16] = {
+            s_tooShort, s_tooShort, s_tooShort, s_tooShort, s_tooShort, s_tooShort, s_tooShort, s_tooShort,
+            s_tooLong | s_overlong2 | s_twoConts | s_overlong3 | s_tooLarge1000 | s_overlong4,
+            s_tooLong | s_overlong2 | s_twoConts | s_overlong3 | s_tooLarge,
+            s_tooLong | s_overlong2 | s_twoConts | s_surrogate | s_tooLarge,
+            s_tooLong | s_overlong2 | s_twoConts | s_surrogate | s_tooLarge,
+            s_tooShort, s_tooShort, s_tooShort, s_tooShort,
+        };
+
+        // Subtracted with saturation from the last bytes of a block: nonzero where a sequence
+        // started there still needs bytes from the next block
+        static constexpr uint8_t s_incomplete[16] = {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+            0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+        };
+
+        static bool Available(const Path path)
+        {
+            switch (path)
+            {
+            case Path::Scalar:
+                return true;
+#ifdef XE_SIMD_X86
+            case Path::SSE4:
+                return CPUFeatures::HasSSE41();
+            case Path::AVX2:
+                return CPUFeatures::HasAVX2();
+#endif
+#ifdef XE_SIMD_NEON
+            case Path::NEON:
+                return true;
+#endif
+            default:
+                return false;
+            }
+        }
+
+        // Each vector path reads the input in 64-byte blocks, the last one padded with zeros
+        // (ASCII, so a sequence cut off by the end still shows as too short)
+        static const uint8_t* Block(const uint8_t* data, const size_t size, const size_t at, uint8_t (&tail)[64])
+        {
+            if (size - at >= 64)
+                return data + at;
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data + at, size - at);
+            return tail;
+        }
+
+#ifdef XE_SIMD_X86
+        XE_TARGET_SSE4 static __m128i Lookup(const uint8_t (&table)[16], const __m128i nibbles)
+        {
+            return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)), nibbles);
+        }
+
+        // Nonzero lanes where 'input', read after 'prev', is not well formed
+        XE_TARGET_SSE4 static __m128i Check(const __m128i input, const __m128i prev)
+        {
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            const __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+            const __m128i special = _mm_and_si128(_mm_and_si128(
+                Lookup(s_firstHigh, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                Lookup(s_firstLow, _mm_and_si128(prev1, nibble))),
+                Lookup(s_secondHigh, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+            // The second and third continuation after a three- or four-byte lead look like
+            // s_twoConts to the lookups: they must carry it exactly where such a lead precedes
+            const __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(0xE0 - 0x80));
+            const __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+            const __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+            return _mm_xor_si128(must23, special);
+        }
+
+        XE_TARGET_SSE4 static bool IsValidSSE4(const uint8_t* data, const size_t size)
+        {
+            const __m128i incomplete = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_incomplete));
+            __m128i error = _mm_setzero_si128();
+            __m128i pending = _mm_setzero_si128(); // sequences the previous block left open
+            __m128i prev = _mm_setzero_si128();
+
+            uint8_t tail[64];
+            for (size_t at = 0; at < size; at += 64)
+            {
+                const uint8_t* block = Block(data, size, at, tail);
+                __m128i v[4];
+                for (int k = 0; k < 4; ++k)
+                    v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * k));
+
+                const __m128i any = _mm_or_si128(_mm_or_si128(v[0], v[1]), _mm_or_si128(v[2], v[3]));
+                if (_mm_movemask_epi8(any) == 0)
+                {
+                    error = _mm_or_si128(error, pending);
+                    pending = _mm_setzero_si128();
+                }
+                else
+                {
+                    error = _mm_or_si128(error, _mm_or_si128(_mm_or_si128(Check(v[0], prev), Check(v[1], v[0])),
+                        _mm_or_si128(Check(v[2], v[1]), Check(v[3], v[2]))));
+                    pending = _mm_subs_epu8(v[3], incomplete);
+                }
+                prev = v[3];
+            }
+            error = _mm_or_si128(error, pending);
+            return _mm_testz_si128(error, error) != 0;
+        }
+
+        XE_TARGET_AVX2 static __m256i Lookup(const uint8_t (&table)[16], const __m256i nibbles)
+        {
+            return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table))), nibbles);
+        }
+
+        // The byte shifts work per 128-bit lane, so the previous bytes come from a permute
+        XE_TARGET_AVX2 static __m256i Check(const __m256i input, const __m256i prev)
+        {
+            const __m256i nibble = _mm256_set1_epi8(0x0F);
+            const __m256i shifted = _mm256_permute2x128_si256(prev, input, 0x21);
+            const __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+            const __m256i special = _mm256_and_si256(_mm256_and_si256(
+                Lookup(s_firstHigh, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                Lookup(s_firstLow, _mm256_and_si256(prev1, nibble))),
+                Lookup(s_secondHigh, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+
+            const __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 14), _mm256_set1_epi8(0xE0 - 0x80));
+            const __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 13), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+            const __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+            return _mm256_xor_si256(must23, special);
+        }
+
+        XE_TARGET_AVX2 static bool IsValidAVX2(const uint8_t* data, const size_t size)
+        {
+            const __m256i incomplete = _mm256_inserti128_si256(_mm256_set1_epi8(static_cast<char>(0xFF)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_incomplete)), 1);
+            __m256i error = _mm256_setzero_si256();
+            __m256i pending = _mm256_setzero_si256();
+            __m256i prev = _mm256_setzero_si256();
+
+            uint8_t tail[64];
+            for (size_t at = 0; at < size; at += 64)
+            {
+                const uint8_t* block = Block(data, size, at, tail);
+                const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+                const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+                if (_mm256_movemask_epi8(_mm256_or_si256(low, high)) == 0)
+                {
+                    error = _mm256_or_si256(error, pending);
+                    pending = _mm256_setzero_si256();
+                }
+                else
+                {
+                    error = _mm256_or_si256(error, _mm256_or_si256(Check(low, prev), Check(high, low)));
+                    pending = _mm256_subs_epu8(high, incomplete);
+                }
+                prev = high;
+            }
+            error = _mm256_or_si256(error, pending);
+            return _mm256_testz_si256(error, error) != 0;
+        }
+#endif // XE_SIMD_X86
+
+#ifdef XE_SIMD_NEON
+        static uint8x16_t Check(const uint8x16_t input, const uint8x16_t prev)
+        {
+            const uint8x16_t nibble = vdupq_n_u8(0x0F);
+            const uint8x16_t prev1 = vextq_u8(prev, input, 15);
+            const uint8x16_t special = vandq_u8(vandq_u8(
+                vqtbl1q_u8(vld1q_u8(s_firstHigh), vshrq_n_u8(prev1, 4)),
+                vqtbl1q_u8(vld1q_u8(s_firstLow), vandq_u8(prev1, nibble))),
+                vqtbl1q_u8(vld1q_u8(s_secondHigh), vshrq_n_u8(input, 4)));
+
+            const uint8x16_t third = vqsubq_u8(vextq_u8(prev, input, 14), vdupq_n_u8(0xE0 - 0x80));
+            const uint8x16_t fourth = vqsubq_u8(vextq_u8(prev, input, 13), vdupq_n_u8(0xF0 - 0x80));
+            const uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+            return veorq_u8(must23, special);
+        }
+
+        static bool IsValidNEON(const uint8_t* data, const size_t size)
+        {
+            const uint8x16_t incomplete = vld1q_u8(s_incomplete);
+            uint8x16_t error = vdupq_n_u8(0);
+            uint8x16_t pending = vdupq_n_u8(0);
+            uint8x16_t prev = vdupq_n_u8(0);
+
+            uint8_t tail[64];
+            for (size_t at = 0; at < size; at += 64)
+            {
+                const uint8_t* block = Block(data, size, at, tail);
+                uint8x16_t v[4];
+                for (int k = 0; k < 4; ++k)
+                    v[k] = vld1q_u8(block + 16 * k);
+
+                const uint8x16_t any = vorrq_u8(vorrq_u8(v[0], v[1]), vorrq_u8(v[2], v[3]));
+                if (vmaxvq_u8(any) < 0x80)
+                {
+                    error = vorrq_u8(error, pending);
+                    pending = vdupq_n_u8(0);
+                }
+                else
+                {
+                    error = vorrq_u8(error, vorrq_u8(vorrq_u8(Check(v[0], prev), Check(v[1], v[0])),
+                        vorrq_u8(Check(v[2], v[1]), Check(v[3], v[2]))));
+                    pending = vqsubq_u8(v[3], incomplete);
+                }
+                prev = v[3];
+            }
+            error = vorrq_u8(error, pending);
+            return vmaxvq_u8(error) == 0;
+        }
+#endif // XE_SIMD_NEON
+    };
+}
+
+#endif // !XE_UTF8_H
\ No newline at end of file
@@ -0,0 +1,307 @@
+/*========================================================
+
+ XEMarkup - WatchedDocument
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_WATCHEDDOCUMENT_H
+#define XE_WATCHEDDOCUMENT_H
+
+#include "Diff.h"
+#include "FileIO.h"
+#include "Hash.h"
+#include "IFormatter.h"
+#include "MappingNode.h"
+#include "SharedDocument.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace xe
+{
+    // Keeps a parsed config file current. On Linux changes are picked up through inotify on the
+    // file's directory (so editors that save by rename are seen); elsewhere the modification
+    // time is polled. Bursts of events are debounced, the file is re-read on the watcher thread,
+    // and nothing is parsed when its bytes hash the same as last time.
+    class WatchedDocument
+    {
+    public:
+        // Called on the watcher thread with the new tree and the paths of xe::Diff(old, new)
+        using Callback = std::function<void(const MappingNode& node, const std::vector<std::string>& changedPaths)>;
+
+        // The formatter must outlive the watcher. Throws if the initial load fails.
+        WatchedDocument(const std::filesystem::path& path, IFormatter& formatter,
+            const std::chrono::milliseconds debounce = std::chrono::milliseconds(100))
+            : m_path(path), m_formatter(formatter), m_debounce(debounce)
+        {
+            std::vector<uint8_t> content = FileIO::ReadFile(m_path);
+            m_contentHash = HashBytes(content.data(), content.size());
+            m_document.Publish(Parse(content));
+            m_lastWrite = LastWriteTime();
+
+#ifdef __linux__
+            if (pipe(m_stopPipe) == 0)
+            {
+                m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            }
+            if (m_inotify >= 0)
+            {
+                std::filesystem::path directory = m_path.parent_path();
+                if (inotify_add_watch(m_inotify, directory.empty() ? "." : directory.c_str(),
+                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+                {
+                    // Out of watches or no access to the directory: poll instead
+                    close(m_inotify);
+                    m_inotify = -1;
+                }
+            }
+#endif
+            m_thread = std::thread([this]() { Run(); });
+        }
+
+        ~WatchedDocument()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_stopMutex);
+                m_stopping = true;
+            }
+            m_stopSignal.notify_all();
+#ifdef __linux__
+            if (m_stopPipe[1] >= 0)
+            {
+                char signal = 0;
+                (void)!write(m_stopPipe[1], &signal, 1);
+            }
+#endif
+            m_thread.join();
+
+#ifdef __linux__
+            if (m_inotify >= 0) close(m_inotify);
+            if (m_stopPipe[0] >= 0) close(m_stopPipe[0]);
+            if (m_stopPipe[1] >= 0) close(m_stopPipe[1]);
+#endif
+        }
+
+        WatchedDocument(const WatchedDocument&) = delete;
+        WatchedDocument& operator=(const WatchedDocument&) = delete;
+
+        SharedDocument::ReadHandle Read() const { return m_document.Read(); }
+        MappingNode Snapshot() const { return m_document.Snapshot(); }
+
+        size_t Subscribe(Callback callback)
+        {
+            std::lock_guard<std::mutex> lock(m_subscriberMutex);
+            m_subscribers.emplace_back(++m_nextSubscriber, std::move(callback));
+            return m_nextSubscriber;
+        }
+
+        void Unsubscribe(const size_t id)
+        {
+            std::lock_guard<std::mutex> lock(m_subscriberMutex);
+            for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it)
+            {
+                if (it->first == id)
+                {
+                    m_subscribers.erase(it);
+                    return;
+                }
+            }
+        }
+
+        // What the most recent failed reload threw; null once a reload succeeds
+        std::exception_ptr LastError() const
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            return m_lastError;
+        }
+
+    private:
+        MappingNode Parse(const std::vector<uint8_t>& content)
+        {
+            if (content.empty())
+                return MappingNode();
+            return m_formatter.LoadContent(content.data(), content.size());
+        }
+
+        std::filesystem::file_time_type LastWriteTime() const
+        {
+            std::error_code error;
+            return std::filesystem::last_write_time(m_path, error);
+        }
+
+        void Run()
+        {
+            while (WaitForChange())
+            {
+                Reload();
+            }
+        }
+
+        // Blocks until the file has changed and then stayed quiet for the debounce period.
+        // Returns false when the watcher is shutting down.
+        bool WaitForChange()
+        {
+#ifdef __linux__
+            if (m_inotify >= 0)
+            {
+                bool changed = false;
+                while (true)
+                {
+                    pollfd fds[2] = { { m_inotify, POLLIN, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+                    int timeout = changed ? static_cast<int>(m_debounce.count()) : -1;
+                    int result = poll(fds, 2, timeout);
+                    if (fds[1].revents)
+                        return false;
+                    if (result == 0)
+                        return true; // quiet for a full debounce period
+
+                    if (fds[0].revents & POLLIN)
+                        changed |= DrainEvents();
+                }
+            }
+#endif
+            std::unique_lock<std::mutex> lock(m_stopMutex);
+            while (true)
+            {
+                if (m_stopSignal.wait_for(lock, m_debounce, [this]() { return m_stopping; }))
+                    return false;
+
+                std::filesystem::file_time_type lastWrite = LastWriteTime();
+                if (lastWrite != m_lastWrite)
+                {
+                    m_lastWrite = lastWrite;
+                    return true;
+                }
+            }
+        }
+
+#ifdef __linux__
+        // True if any queued event concerns the watched file
+        bool DrainEvents()
+        {
+            alignas(inotify_event) char buffer[4096];
+            const std::string name = m_path.filename().string();
+            bool relevant = false;
+
+            ssize_t length;
+            while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* pos = buffer; pos < buffer + length;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(pos);
+                    if (event->len > 0 && name == event->name)
+                        relevant = true;
+                    pos += sizeof(inotify_event) + event->len;
+                }
+            }
+            return relevant;
+        }
+#endif
+
+        void Reload()
+        {
+            try
+            {
+                std::vector<uint8_t> content = FileIO::ReadFile(m_path);
+                uint64_t hash = HashBytes(content.data(), content.size());
+                if (hash == m_contentHash)
+                    return;
+
+                MappingNode next = Parse(content);
+                MappingNode previous = m_document.Snapshot();
+
+                std::vector<std::string> changedPaths;
+                for (PatchOperation& operation : Diff(previous, next).operations)
+                {
+                    changedPaths.push_back(std::move(operation.path));
+                }
+
+                MappingNode published = next.Share();
+                m_document.Publish(std::move(next));
+                m_contentHash = hash;
+                {
+                    std::lock_guard<std::mutex> lock(m_errorMutex);
+                    m_lastError = nullptr;
+                }
+
+                if (changedPaths.empty())
+                    return;
+
+                std::vector<std::pair<size_t, Callback>> subscribers;
+                {
+                    std::lock_guard<std::mutex> lock(m_subscriberMutex);
+                    subscribers = m_subscribers;
+                }
+                for (const auto& subscriber : subscribers)
+                {
+                    subscriber.second(published, changedPaths);
+                }
+            }
+            catch (...)
+            {
+                // Half-written or malformed file: keep serving the last good tree
+                std::lock_guard<std::mutex> lock(m_errorMutex);
+                m_lastError = std::current_exception();
+            }
+        }
+
+        std::filesystem::path m_path;
+        IFormatter& m_formatter;
+        std::chrono::milliseconds m_debounce;
+
+        SharedDocument m_document;
+        uint64_t m_contentHash = 0;
+        std::filesystem::file_time_type m_lastWrite;
+
+        std::mutex m_subscriberMutex;
+        std::vector<std::pair<size_t, Callback>> m_subscribers;
+        size_t m_nextSubscriber = 0;
+
+        mutable std::mutex m_errorMutex;
+        std::exception_ptr m_lastError;
+
+        std::mutex m_stopMutex;
+        std::condition_variable m_stopSignal;
+        bool m_stopping = false;
+
+#ifdef __linux__
+        int m_inotify = -1;
+        int m_stopPipe[2] = { -1, -1 };
+#endif
+        std::thread m_thread;
+    };
+}
+
+#endif // !XE_WATCHEDDOCUMENT_H
\ No newline at end of file
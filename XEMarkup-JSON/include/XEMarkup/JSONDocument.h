@@ -0,0 +1,196 @@
+/*========================================================
+
+ XEMarkup - JSON Document
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_JSONDOCUMENT_H
+#define XE_JSONDOCUMENT_H
+
+#include <XEMarkup/MappingNode.h>
+#include <XEMarkup/ParseResult.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace xe
+{
+	class JSONDocument;
+
+	// One value inside a JSONDocument. A cheap handle: nothing is decoded until a scalar is read
+	// with As / TryAs or a subtree is turned into a MappingNode with Materialize. Looking up a
+	// missing key or index gives an invalid value rather than throwing, so chains like
+	// doc["a"]["b"][3] are safe; reading an invalid value throws. Only valid while its
+	// document is alive.
+	class JSONValue
+	{
+	public:
+		class Iterator;
+		struct Tape; // the document's text and index, defined in JSONDocument.cpp
+
+		JSONValue() = default;
+
+		bool IsValid() const noexcept { return m_tape != nullptr; }
+		explicit operator bool() const noexcept { return IsValid(); }
+
+		bool IsObject() const noexcept;
+		bool IsArray() const noexcept;
+		bool IsString() const noexcept;
+		bool IsNumber() const noexcept;
+		bool IsBoolean() const noexcept;
+		bool IsNull() const noexcept;
+
+		// Member count of an object or element count of an array
+		size_t Size() const;
+
+		// Key of this value when it was reached as an object member; empty otherwise
+		std::string Key() const;
+
+		// Skips over earlier members without decoding them. A repeated key finds its last
+		// value, as a full load would.
+		JSONValue operator[](std::string_view key) const;
+
+		// Steps over the earlier elements one subtree at a time; iterate for sequential access
+		JSONValue operator[](size_t index) const;
+
+		// Members (objects) or elements (arrays), in document order
+		Iterator begin() const;
+		Iterator end() const;
+
+		// The value's source text
+		std::string_view Raw() const;
+
+		// A string's contents with escape sequences left as written; no copy
+		std::string_view RawString() const;
+
+		template<typename T>
+		T As() const
+		{
+			static_assert(!std::is_same_v<T, std::string_view>, "Use RawString() for a view into the document");
+			return Decode().As<T>();
+		}
+
+		template<typename T>
+		T As(const T& fallback) const
+		{
+			std::optional<T> value = TryAs<T>();
+			return (value) ? *value : fallback;
+		}
+
+		template<typename T>
+		std::optional<T> TryAs() const noexcept
+		{
+			static_assert(!std::is_same_v<T, std::string_view>, "Use RawString() for a view into the document");
+			if (!IsValid() || IsObject() || IsArray())
+				return std::nullopt;
+			XE_TRY
+			{
+				return Decode().TryAs<T>();
+			}
+			XE_CATCH_ALL
+			{
+				return std::nullopt;
+			}
+			return std::nullopt;
+		}
+
+		// Decodes this value and everything under it, as JSONFormatter::LoadContent would
+		MappingNode Materialize() const;
+
+	private:
+		friend class JSONDocument;
+
+		JSONValue(const Tape* tape, const uint32_t index, const uint32_t key) : m_tape(tape), m_index(index), m_key(key) {}
+
+		// A scalar as a MappingNode; throws for containers
+		MappingNode Decode() const;
+
+		const Tape* m_tape = nullptr;
+		uint32_t m_index = 0;
+		uint32_t m_key = 0; // tape index of the member key, or 0 (the root is never a key)
+	};
+
+	class JSONValue::Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = JSONValue;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const JSONValue*;
+		using reference = JSONValue;
+
+		Iterator() = default;
+		JSONValue operator*() const;
+		Iterator& operator++();
+		Iterator operator++(int) { Iterator result = *this; ++*this; return result; }
+		bool operator==(const Iterator& other) const noexcept { return m_remaining == other.m_remaining; }
+		bool operator!=(const Iterator& other) const noexcept { return m_remaining != other.m_remaining; }
+
+	private:
+		friend class JSONValue;
+		Iterator(const Tape* tape, const uint32_t index, const size_t remaining, const bool object)
+			: m_tape(tape), m_index(index), m_remaining(remaining), m_object(object) {}
+
+		const Tape* m_tape = nullptr;
+		uint32_t m_index = 0; // next member's key (objects) or next element
+		size_t m_remaining = 0;
+		bool m_object = false;
+	};
+
+	// A JSON document read on demand. Construction keeps the text and makes a single pass
+	// over it that checks the structure and records where every value starts and ends, with
+	// a link past each container so lookups skip whole subtrees. Nothing is decoded or
+	// allocated per value until it is read. Throws std::runtime_error on malformed structure
+	// (TryParse reports it instead); bad escapes or numbers inside a value surface when that
+	// value is read.
+	class JSONDocument
+	{
+	public:
+		explicit JSONDocument(std::string content);
+		JSONDocument(const uint8_t* data, size_t size);
+
+		// Empty, with the reason in out_error when given, if the text is not JSON. Never
+		// throws for bad input, so it is the entry point for builds without exceptions.
+		static std::optional<JSONDocument> TryParse(std::string content, ParseError* out_error = nullptr);
+
+		JSONValue Root() const noexcept;
+		JSONValue operator[](std::string_view key) const { return Root()[key]; }
+		JSONValue operator[](size_t index) const { return Root()[index]; }
+
+		MappingNode Materialize() const { return Root().Materialize(); }
+
+		std::string_view Content() const noexcept;
+
+	private:
+		explicit JSONDocument(std::shared_ptr<const JSONValue::Tape> tape) : m_tape(std::move(tape)) {}
+
+		std::shared_ptr<const JSONValue::Tape> m_tape; // stable address for JSONValue handles
+	};
+}
+
+#endif // !XE_JSONDOCUMENT_H
\ No newline at end of file
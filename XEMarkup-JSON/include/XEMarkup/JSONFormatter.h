@@ -26,18 +26,45 @@
 #define XE_JSONFORMATTER_H
 
 #include <XEMarkup/IFormatter.h>
+#include <XEMarkup/JSONDocument.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace xe
 {
 	class JSONFormatter : public IFormatter
 	{
 	public:
-		JSONFormatter() = default;
-		JSONFormatter(const bool usePrettyFormat) : m_usePrettyFormat(usePrettyFormat) {}
+		JSONFormatter();
+		JSONFormatter(const bool usePrettyFormat);
+		// Copies the settings; the copy starts without a previous output of its own
+		JSONFormatter(const JSONFormatter& other);
+		JSONFormatter& operator=(const JSONFormatter& other);
+		JSONFormatter(JSONFormatter&& other) noexcept;
+		JSONFormatter& operator=(JSONFormatter&& other) noexcept;
+		~JSONFormatter();
 
 		MappingNode LoadFile(const std::filesystem::path& path) override;
+		using IFormatter::LoadFile;
 		MappingNode LoadContent(const std::string& content) override;
 		MappingNode LoadContent(const std::vector<uint8_t>& content) override;
+		MappingNode LoadContent(const uint8_t* data, size_t size) override;
+		MappingNode LoadContent(const uint8_t* data, size_t size, const Projection& projection) override;
+		using IFormatter::TryLoadContent;
+		ParseResult TryLoadContent(const uint8_t* data, size_t size) override;
+
+		// Lazy view that indexes the text in one pass and decodes values only as they are read
+		JSONDocument LoadLazy(std::string content) const { return JSONDocument(std::move(content)); }
+		JSONDocument LoadLazyFile(const std::filesystem::path& path) const;
+		std::optional<JSONDocument> TryLoadLazy(std::string content, ParseError* out_error = nullptr) const
+		{
+			return JSONDocument::TryParse(std::move(content), out_error);
+		}
+		std::optional<JSONDocument> TryLoadLazyFile(const std::filesystem::path& path, ParseError* out_error = nullptr) const;
 
 		bool SaveFile(const MappingNode& node, const std::filesystem::path& path) override;
 		void SaveContent(const MappingNode& node, std::string& out_content) override;
@@ -46,8 +73,34 @@ namespace xe
 		bool GetUsePrettyFormat() const { return m_usePrettyFormat; }
 		void SetUsePrettyFormat(const bool usePrettyFormat) { m_usePrettyFormat = usePrettyFormat; }
 
+		// In incremental mode the formatter keeps its previous output and splices in the bytes of
+		// every subtree whose MappingNode::Hash() is unchanged, so re-saving after a small edit
+		// only serializes the edited path. A cached span is reused only if its type and element
+		// count match as well as the hash, so output differs from the normal mode only if two
+		// different subtrees agree on all three. Saves through one formatter are serialized on a
+		// lock, since they share the previous output (AsyncSave workers and the caller may save
+		// at once).
+		bool GetIncremental() const { return m_incremental; }
+		void SetIncremental(const bool incremental);
+
+		// Where a container subtree landed in the previous output
+		struct CachedSpan
+		{
+			uint64_t key; // MappingNode::Hash(), combined with the depth when pretty printing
+			size_t offset;
+			size_t length;
+			size_t size; // element count of the subtree's root
+			bool isMapping;
+		};
+
 	private:
+		struct Incremental; // previous output and its spans, with their lock
+
+		Incremental& Cache();
+
 		bool m_usePrettyFormat = false;
+		bool m_incremental = false;
+		std::unique_ptr<Incremental> m_cache;
 	};
 }
 
@@ -0,0 +1,613 @@
+/*========================================================
+
+ XEMarkup - JSON Document
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#include "XEMarkup/JSONDocument.h"
+
+#include <XEMarkup/Exceptions.h>
+#include <XEMarkup/JSONFormatter.h>
+
+#include "JSONScanner.h"
+#include "JSONText.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace xe;
+
+struct JSONValue::Tape
+{
+    enum class Kind : uint8_t
+    {
+        Object,
+        Array,
+        String,
+        EscapedString, // has backslash escapes, so it must be decoded to compare
+        Number,
+        True,
+        False,
+        Null,
+    };
+
+    // One per value, and one per object key ahead of its value
+    struct Entry
+    {
+        uint32_t begin; // offset of the first byte
+        uint32_t end; // offset past the last byte
+        uint32_t next; // index of the entry after this value and everything inside it
+        uint32_t count; // members or elements, for containers
+        Kind kind;
+    };
+
+    std::string content;
+    std::vector<Entry> entries;
+
+    std::string_view Text(const Entry& entry) const
+    {
+        return std::string_view(content.data() + entry.begin, entry.end - entry.begin);
+    }
+
+    // Between the quotes
+    std::string_view Inner(const Entry& entry) const
+    {
+        return std::string_view(content.data() + entry.begin + 1, entry.end - entry.begin - 2);
+    }
+
+    bool KeyEquals(const Entry& entry, const std::string_view key) const
+    {
+        if (entry.kind == Kind::String)
+            return Inner(entry) == key;
+
+        std::string decoded;
+        json_text::Unescape(Inner(entry), decoded);
+        return decoded == key;
+    }
+};
+
+using Tape = JSONValue::Tape;
+using Kind = Tape::Kind;
+
+static bool IsSpace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool IsNumberChar(const char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+namespace
+{
+enum class Expect : uint8_t
+{
+    Value,
+    ValueOrClose, // just after '['
+    Key,
+    KeyOrClose, // just after '{'
+    Colon,
+    CommaOrClose,
+    End,
+};
+}
+
+// The single structural pass. Checks brackets, commas, colons, literals and the shape of
+// numbers; string escapes are only checked when a string is decoded. Returns why the text is
+// not JSON, with 'pos' on the offending byte, or null.
+static const char* BuildTape(Tape& tape, size_t& pos)
+{
+    const std::string& text = tape.content;
+    const size_t size = text.size();
+    std::vector<Tape::Entry>& entries = tape.entries;
+    entries.reserve(size / 8 + 1);
+    std::vector<uint32_t> open; // entries of unclosed containers
+    Expect expect = Expect::Value;
+    pos = 0;
+
+    auto push = [&](const Kind kind, const size_t begin, const size_t end)
+    {
+        const uint32_t index = static_cast<uint32_t>(entries.size());
+        entries.push_back({ static_cast<uint32_t>(begin), static_cast<uint32_t>(end), index + 1, 0, kind });
+    };
+
+    auto afterValue = [&]()
+    {
+        expect = (open.empty()) ? Expect::End : Expect::CommaOrClose;
+    };
+
+    // Leaves pos on the closing quote
+    auto scanString = [&](Kind& kind) -> const char*
+    {
+        kind = Kind::String;
+        for (++pos; pos < size; ++pos)
+        {
+            const char c = text[pos];
+            if (c == '"')
+                return nullptr;
+            if (c == '\\')
+            {
+                kind = Kind::EscapedString;
+                ++pos;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                return "control character in string";
+            }
+        }
+        return "unterminated string";
+    };
+
+    auto close = [&](const char bracket) -> const char*
+    {
+        if (open.empty())
+            return "unexpected closing bracket";
+        Tape::Entry& container = entries[open.back()];
+        if ((bracket == '}') != (container.kind == Kind::Object))
+            return "mismatched bracket";
+        container.end = static_cast<uint32_t>(pos + 1);
+        container.next = static_cast<uint32_t>(entries.size());
+        open.pop_back();
+        ++pos;
+        afterValue();
+        return nullptr;
+    };
+
+    while (true)
+    {
+        while (pos < size && IsSpace(text[pos]))
+            ++pos;
+        if (pos == size)
+            break;
+
+        const char c = text[pos];
+        switch (expect)
+        {
+        case Expect::End:
+            return "unexpected text after the document";
+
+        case Expect::Colon:
+            if (c != ':')
+                return "expected ':'";
+            ++pos;
+            expect = Expect::Value;
+            continue;
+
+        case Expect::CommaOrClose:
+            if (c == ',')
+            {
+                ++pos;
+                expect = (entries[open.back()].kind == Kind::Object) ? Expect::Key : Expect::Value;
+            }
+            else if (c == '}' || c == ']')
+            {
+                if (const char* reason = close(c))
+                    return reason;
+            }
+            else
+            {
+                return "expected ',' or a closing bracket";
+            }
+            continue;
+
+        case Expect::KeyOrClose:
+        case Expect::Key:
+            if (c == '}' && expect == Expect::KeyOrClose)
+            {
+                if (const char* reason = close(c))
+                    return reason;
+                continue;
+            }
+            if (c != '"')
+                return "expected a key";
+            {
+                const size_t begin = pos;
+                Kind kind;
+                if (const char* reason = scanString(kind))
+                    return reason;
+                push(kind, begin, ++pos);
+            }
+            expect = Expect::Colon;
+            continue;
+
+        case Expect::ValueOrClose:
+            if (c == ']')
+            {
+                if (const char* reason = close(c))
+                    return reason;
+                continue;
+            }
+            break;
+
+        case Expect::Value:
+            break;
+        }
+
+        // A value
+        if (!open.empty())
+            ++entries[open.back()].count;
+
+        const size_t begin = pos;
+        if (c == '{' || c == '[')
+        {
+            open.push_back(static_cast<uint32_t>(entries.size()));
+            push((c == '{') ? Kind::Object : Kind::Array, begin, begin + 1);
+            ++pos;
+            expect = (c == '{') ? Expect::KeyOrClose : Expect::ValueOrClose;
+            continue;
+        }
+
+        if (c == '"')
+        {
+            Kind kind;
+            if (const char* reason = scanString(kind))
+                return reason;
+            push(kind, begin, ++pos);
+        }
+        else if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            while (pos < size && IsNumberChar(text[pos]))
+                ++pos;
+            if (!json_text::IsNumber(std::string_view(text.data() + begin, pos - begin)))
+                return "invalid number";
+            push(Kind::Number, begin, pos);
+        }
+        else if (text.compare(pos, 4, "true") == 0)
+        {
+            pos += 4;
+            push(Kind::True, begin, pos);
+        }
+        else if (text.compare(pos, 5, "false") == 0)
+        {
+            pos += 5;
+            push(Kind::False, begin, pos);
+        }
+        else if (text.compare(pos, 4, "null") == 0)
+        {
+            pos += 4;
+            push(Kind::Null, begin, pos);
+        }
+        else
+        {
+            return "expected a value";
+        }
+        afterValue();
+    }
+
+    if (entries.empty())
+        return "empty document";
+    if (!open.empty())
+        return "unexpected end of input";
+    return nullptr;
+}
+
+// Stage one has already checked that a string token closes, so only escapes are looked for
+static Kind StringKind(const std::string& text, const size_t begin, const size_t end)
+{
+    const size_t size = end - begin - 2;
+    return (json_scan::FindBackslash(text.data() + begin + 1, size) == size) ? Kind::String : Kind::EscapedString;
+}
+
+// The same pass over the token offsets from json_scan::FindStructurals, which has already
+// found where every string ends. Gives up rather than failing; BuildTape then runs to say why.
+static bool BuildTapeFromStructurals(Tape& tape, const json_scan::Structurals& structurals)
+{
+    const std::string& text = tape.content;
+    std::vector<Tape::Entry>& entries = tape.entries;
+    entries.reserve(structurals.Size()); // never more entries than tokens
+    std::vector<uint32_t> open;
+    Expect expect = Expect::Value;
+
+    auto push = [&](const Kind kind, const size_t begin, const size_t end)
+    {
+        const uint32_t index = static_cast<uint32_t>(entries.size());
+        entries.push_back({ static_cast<uint32_t>(begin), static_cast<uint32_t>(end), index + 1, 0, kind });
+    };
+
+    for (size_t i = 0; i < structurals.Size(); ++i)
+    {
+        // A token runs up to the last byte before the next one that is not whitespace
+        const size_t begin = structurals[i];
+        size_t end = (i + 1 < structurals.Size()) ? structurals[i + 1] : text.size();
+        while (IsSpace(text[end - 1]))
+            --end;
+
+        const char c = text[begin];
+        if ((c == '}' || c == ']') &&
+            (expect == Expect::CommaOrClose || expect == Expect::KeyOrClose || expect == Expect::ValueOrClose))
+        {
+            Tape::Entry& container = entries[open.back()];
+            if ((c == '}') != (container.kind == Kind::Object))
+                return false;
+            container.end = static_cast<uint32_t>(begin + 1);
+            container.next = static_cast<uint32_t>(entries.size());
+            open.pop_back();
+            expect = (open.empty()) ? Expect::End : Expect::CommaOrClose;
+            continue;
+        }
+
+        switch (expect)
+        {
+        case Expect::End:
+            return false;
+        case Expect::Colon:
+            if (c != ':')
+                return false;
+            expect = Expect::Value;
+            continue;
+        case Expect::CommaOrClose:
+            if (c != ',')
+                return false;
+            expect = (entries[open.back()].kind == Kind::Object) ? Expect::Key : Expect::Value;
+            continue;
+        case Expect::Key:
+        case Expect::KeyOrClose:
+            if (c != '"')
+                return false;
+            push(StringKind(text, begin, end), begin, end);
+            expect = Expect::Colon;
+            continue;
+        default:
+            break;
+        }
+
+        if (!open.empty())
+            ++entries[open.back()].count;
+
+        if (c == '{' || c == '[')
+        {
+            open.push_back(static_cast<uint32_t>(entries.size()));
+            push((c == '{') ? Kind::Object : Kind::Array, begin, begin + 1);
+            expect = (c == '{') ? Expect::KeyOrClose : Expect::ValueOrClose;
+            continue;
+        }
+
+        const std::string_view token(text.data() + begin, end - begin);
+        if (c == '"')
+            push(StringKind(text, begin, end), begin, end);
+        else if (json_text::IsNumber(token))
+            push(Kind::Number, begin, end);
+        else if (token == "true")
+            push(Kind::True, begin, end);
+        else if (token == "false")
+            push(Kind::False, begin, end);
+        else if (token == "null")
+            push(Kind::Null, begin, end);
+        else
+            return false;
+        expect = (open.empty()) ? Expect::End : Expect::CommaOrClose;
+    }
+    return expect == Expect::End;
+}
+
+// Indexes tape.content; false with 'error' filled in when it is not JSON
+static bool Index(Tape& tape, ParseError& error)
+{
+    if (tape.content.size() >= std::numeric_limits<uint32_t>::max())
+    {
+        error.code = ParseError::Code::OutOfRange;
+        error.message = "JSON document too large for a lazy index";
+        return false;
+    }
+
+    json_scan::Structurals structurals;
+    if (json_scan::FindStructurals(tape.content.data(), tape.content.size(), structurals) &&
+        BuildTapeFromStructurals(tape, structurals))
+        return true;
+
+    tape.entries.clear();
+    size_t pos = 0;
+    const char* reason = BuildTape(tape, pos);
+    if (!reason)
+        return true;
+
+    error.code = ParseError::Code::Syntax;
+    error.Locate(tape.content, pos);
+    error.message = "Invalid JSON at offset " + std::to_string(pos) + ": " + reason;
+    return false;
+}
+
+JSONDocument::JSONDocument(std::string content)
+{
+    std::shared_ptr<Tape> tape = std::make_shared<Tape>();
+    tape->content = std::move(content);
+
+    ParseError error;
+    if (!Index(*tape, error))
+        XE_THROW(std::runtime_error(error.message));
+    m_tape = std::move(tape);
+}
+
+JSONDocument::JSONDocument(const uint8_t* data, size_t size)
+    : JSONDocument(std::string(reinterpret_cast<const char*>(data), size))
+{
+}
+
+std::optional<JSONDocument> JSONDocument::TryParse(std::string content, ParseError* out_error)
+{
+    std::shared_ptr<Tape> tape = std::make_shared<Tape>();
+    tape->content = std::move(content);
+
+    ParseError error;
+    if (!Index(*tape, error))
+    {
+        if (out_error)
+            *out_error = std::move(error);
+        return std::nullopt;
+    }
+    return JSONDocument(std::move(tape));
+}
+
+JSONValue JSONDocument::Root() const noexcept
+{
+    return JSONValue(m_tape.get(), 0, 0);
+}
+
+std::string_view JSONDocument::Content() const noexcept
+{
+    return m_tape->content;
+}
+
+bool JSONValue::IsObject() const noexcept { return m_tape && m_tape->entries[m_index].kind == Kind::Object; }
+bool JSONValue::IsArray() const noexcept { return m_tape && m_tape->entries[m_index].kind == Kind::Array; }
+bool JSONValue::IsNumber() const noexcept { return m_tape && m_tape->entries[m_index].kind == Kind::Number; }
+bool JSONValue::IsNull() const noexcept { return m_tape && m_tape->entries[m_index].kind == Kind::Null; }
+
+bool JSONValue::IsString() const noexcept
+{
+    return m_tape && (m_tape->entries[m_index].kind == Kind::String || m_tape->entries[m_index].kind == Kind::EscapedString);
+}
+
+bool JSONValue::IsBoolean() const noexcept
+{
+    return m_tape && (m_tape->entries[m_index].kind == Kind::True || m_tape->entries[m_index].kind == Kind::False);
+}
+
+size_t JSONValue::Size() const
+{
+    if (!IsObject() && !IsArray())
+        XE_THROW(std::runtime_error("Cannot get size of a non-container JSON value"));
+    return m_tape->entries[m_index].count;
+}
+
+std::string JSONValue::Key() const
+{
+    std::string result;
+    if (m_tape && m_key != 0)
+        json_text::Unescape(m_tape->Inner(m_tape->entries[m_key]), result);
+    return result;
+}
+
+JSONValue JSONValue::operator[](const std::string_view key) const
+{
+    if (!IsObject())
+        return JSONValue();
+
+    const std::vector<Tape::Entry>& entries = m_tape->entries;
+    JSONValue result;
+    uint32_t member = m_index + 1;
+    for (uint32_t i = 0; i < entries[m_index].count; ++i)
+    {
+        if (m_tape->KeyEquals(entries[member], key))
+            result = JSONValue(m_tape, member + 1, member);
+        member = entries[member + 1].next;
+    }
+    return result;
+}
+
+JSONValue JSONValue::operator[](const size_t index) const
+{
+    if (!IsArray() || index >= m_tape->entries[m_index].count)
+        return JSONValue();
+
+    uint32_t element = m_index + 1;
+    for (size_t i = 0; i < index; ++i)
+        element = m_tape->entries[element].next;
+    return JSONValue(m_tape, element, 0);
+}
+
+JSONValue::Iterator JSONValue::begin() const
+{
+    if (!IsObject() && !IsArray())
+        return Iterator();
+    return Iterator(m_tape, m_index + 1, m_tape->entries[m_index].count, IsObject());
+}
+
+JSONValue::Iterator JSONValue::end() const
+{
+    return Iterator();
+}
+
+JSONValue JSONValue::Iterator::operator*() const
+{
+    return (m_object) ? JSONValue(m_tape, m_index + 1, m_index) : JSONValue(m_tape, m_index, 0);
+}
+
+JSONValue::Iterator& JSONValue::Iterator::operator++()
+{
+    m_index = m_tape->entries[(m_object) ? m_index + 1 : m_index].next;
+    --m_remaining;
+    return *this;
+}
+
+std::string_view JSONValue::Raw() const
+{
+    if (!m_tape)
+        XE_THROW(std::runtime_error("Invalid JSON value"));
+    return m_tape->Text(m_tape->entries[m_index]);
+}
+
+std::string_view JSONValue::RawString() const
+{
+    if (!IsString())
+        XE_THROW(std::runtime_error("JSON value is not a string"));
+    return m_tape->Inner(m_tape->entries[m_index]);
+}
+
+MappingNode JSONValue::Decode() const
+{
+    if (!m_tape)
+        XE_THROW(std::runtime_error("Invalid JSON value"));
+
+    MappingNode result;
+    const Tape::Entry& entry = m_tape->entries[m_index];
+    switch (entry.kind)
+    {
+    case Kind::String:
+        result = m_tape->Inner(entry);
+        break;
+    case Kind::EscapedString:
+    {
+        std::string decoded;
+        json_text::Unescape(m_tape->Inner(entry), decoded);
+        result = decoded;
+        break;
+    }
+    case Kind::Number:
+        result.SetRawNumber(m_tape->Text(entry));
+        break;
+    case Kind::True:
+        result = true;
+        break;
+    case Kind::False:
+        result = false;
+        break;
+    case Kind::Null:
+        break;
+    case Kind::Object:
+    case Kind::Array:
+        XE_THROW(std::runtime_error("JSON value is a container; use Materialize()"));
+    }
+    return result;
+}
+
+MappingNode JSONValue::Materialize() const
+{
+    if (!IsObject() && !IsArray())
+        return Decode();
+
+    std::string_view text = Raw();
+    JSONFormatter formatter;
+    return formatter.LoadContent(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
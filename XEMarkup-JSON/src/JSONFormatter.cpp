@@ -24,84 +24,593 @@
 
 #include "XEMarkup/JSONFormatter.h"
 
+#include <XEMarkup/Base64.h>
+#include <XEMarkup/FileIO.h>
+#include <XEMarkup/NumberFormat.h>
+#include <XEMarkup/Path.h>
+#include <XEMarkup/StringArena.h>
+
+#include "JSONScanner.h"
+#include "JSONText.h"
+
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 using namespace xe;
 using json = nlohmann::json;
 
-static void Import(const json& in, MappingNode& out)
+namespace
+{
+// Builds the tree straight from nlohmann's SAX events, without an intermediate json value.
+// Integers arrive already parsed and are stored narrowed as before; decimals are kept as
+// their source text (MappingNode::SetRawNumber) and only converted if read. Strings are
+// borrowed from 'arena' when one is given. Errors are thrown, or recorded in 'error' when
+// one is given. With a projection walker, values it does not select are still scanned by the
+// lexer but never become nodes.
+class Importer
 {
-    if (in.is_object())
+public:
+    Importer(MappingNode& root, std::shared_ptr<StringArena> arena, ParseError* error = nullptr,
+        Projection::Walker* walker = nullptr)
+        : m_root(root), m_arena(std::move(arena)), m_error(error), m_walker(walker) {}
+
+    bool null()
+    {
+        if (Admit(false))
+            Next();
+        return true;
+    }
+
+    bool boolean(const bool value)
+    {
+        if (Admit(false))
+            Next() = value;
+        return true;
+    }
+
+    bool number_integer(const json::number_integer_t value)
+    {
+        if (!Admit(false))
+            return true;
+        if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max())
+            Next() = static_cast<int32_t>(value);
+        else
+            Next() = static_cast<int64_t>(value);
+        return true;
+    }
+
+    bool number_unsigned(const json::number_unsigned_t value)
+    {
+        if (!Admit(false))
+            return true;
+        if (value <= std::numeric_limits<uint32_t>::max())
+            Next() = static_cast<uint32_t>(value);
+        else
+            Next() = static_cast<uint64_t>(value);
+        return true;
+    }
+
+    bool number_float(const json::number_float_t, const json::string_t& text)
+    {
+        if (Admit(false))
+            Next().SetRawNumber(text);
+        return true;
+    }
+
+    bool string(json::string_t& value)
+    {
+        if (!Admit(false))
+            return true;
+        if (m_arena)
+            Next().SetBorrowedString(StringArena::Borrow(m_arena, value));
+        else
+            Next() = std::string_view(value);
+        return true;
+    }
+
+    bool binary(json::binary_t&)
+    {
+        if (Admit(false))
+            Next();
+        return true;
+    }
+
+    bool start_object(const size_t)
+    {
+        if (Admit(true))
+            m_stack.push_back({ &Next(), true, m_descend });
+        m_key.clear();
+        return true;
+    }
+
+    bool key(json::string_t& key)
+    {
+        m_key = key;
+        return true;
+    }
+
+    bool end_object()
+    {
+        Close();
+        m_key.clear();
+        return true;
+    }
+
+    bool start_array(const size_t)
+    {
+        if (Admit(true))
+            m_stack.push_back({ &Next(), false, m_descend });
+        return true;
+    }
+
+    bool end_array()
+    {
+        Close();
+        return true;
+    }
+
+    bool parse_error(const size_t position, const std::string&, const nlohmann::detail::exception& ex)
     {
-        for (auto it = in.begin(); it != in.end(); ++it)
+        if (m_error)
         {
-            Import(it.value(), out[it.key()]);
+            m_error->code = (ex.id / 100 == 1) ? ParseError::Code::Syntax :
+                (ex.id / 100 == 4) ? ParseError::Code::OutOfRange : ParseError::Code::Other;
+            m_error->offset = (position > 0) ? position - 1 : 0; // position counts the bad byte
+            m_error->path = Path();
+            m_error->message = ex.what();
+            return false;
+        }
+
+        // Rethrown as the type json::parse would throw
+        switch (ex.id / 100)
+        {
+            case 1: XE_THROW(*static_cast<const json::parse_error*>(&ex));
+            case 4: XE_THROW(*static_cast<const json::out_of_range*>(&ex));
+            default: XE_THROW(std::runtime_error(ex.what()));
         }
-        return;
     }
 
-    if (in.is_array())
+private:
+    struct Container
     {
-        for (const auto& child : in)
+        MappingNode* node;
+        bool isObject;
+        bool descend; // children are offered to the walker one by one
+        size_t count = 0; // source elements seen, when descending into an array
+    };
+
+    // Whether the value starting now is loaded; everything is without a walker
+    bool Admit(const bool container)
+    {
+        if (m_skipDepth > 0)
         {
-            MappingNode result;
-            Import(child, result);
-            out.PushBack(result);
+            m_skipDepth += container;
+            return false;
         }
-        return;
+
+        m_descend = false;
+        if (!m_walker)
+            return true;
+
+        Projection::Decision decision = Projection::Decision::Keep;
+        if (m_stack.empty())
+        {
+            decision = m_walker->Root();
+        }
+        else if (m_stack.back().descend)
+        {
+            Container& parent = m_stack.back();
+            decision = (parent.isObject) ? m_walker->Enter(m_key) : m_walker->Enter(parent.count++);
+        }
+
+        if (decision == Projection::Decision::Descend && !container)
+        {
+            // The selected path goes deeper than this scalar
+            if (!m_stack.empty())
+                m_walker->Leave();
+            decision = Projection::Decision::Skip;
+        }
+        if (decision == Projection::Decision::Skip)
+        {
+            m_skipDepth = container;
+            return false;
+        }
+
+        m_descend = (decision == Projection::Decision::Descend);
+        return true;
     }
 
-    if (in.is_boolean())
+    void Close()
     {
-        out = in.get<bool>();
-        return;
+        if (m_skipDepth > 0)
+        {
+            --m_skipDepth;
+            return;
+        }
+
+        const Container container = m_stack.back();
+        m_stack.pop_back();
+        if (!container.descend || m_stack.empty())
+            return;
+
+        m_walker->Leave();
+        if (!container.node->IsDefined())
+        {
+            // Nothing under it was selected
+            MappingNode& parent = *m_stack.back().node;
+            if (parent.IsArray())
+                parent.Erase(parent.Size() - 1);
+            else
+                parent.Erase(std::string(container.node->Key()));
+        }
     }
 
-    if (in.is_number())
+    // JSON Pointer to the value being read: open containers, then the pending key or index
+    std::string Path() const
     {
-        if (in.is_number_float())
+        std::string result;
+        for (size_t i = 0; i < m_stack.size(); ++i)
         {
-            if (in.is_number_float())
+            const Container& container = m_stack[i];
+            const bool innermost = (i + 1 == m_stack.size());
+            if (container.isObject)
             {
-                out = in.get<float>();
-                return;
+                std::string_view key = (innermost) ? std::string_view(m_key) : m_stack[i + 1].node->Key();
+                if (innermost && key.empty())
+                    break;
+                Path::AppendToken(result, key);
+            }
+            else
+            {
+                size_t size = (container.node->IsArray()) ? container.node->Size() : 0;
+                result += '/';
+                result += std::to_string((innermost) ? size : size - 1);
             }
-            out = in.get<double>();
-            return;
         }
+        return result;
+    }
 
-        if (!in.is_number_unsigned())
+    // The node the next value is written to. Empty containers stay null, as they always have.
+    MappingNode& Next()
+    {
+        if (m_stack.empty())
         {
-            if (in.is_number_integer() && in.get<int64_t>() >= std::numeric_limits<int32_t>::min() &&
-                in.get<int64_t>() <= std::numeric_limits<int32_t>::max())
+            return m_root;
+        }
+
+        MappingNode& parent = *m_stack.back().node;
+        if (m_stack.back().isObject)
+        {
+            // A repeated key takes the last value
+            MappingNode& child = parent[m_key];
+            child.Clear();
+            return child;
+        }
+        parent.PushBack(MappingNode());
+        return parent[parent.Size() - 1];
+    }
+
+    MappingNode& m_root;
+    std::shared_ptr<StringArena> m_arena;
+    ParseError* m_error;
+    Projection::Walker* m_walker;
+    std::vector<Container> m_stack;
+    std::string m_key;
+    size_t m_skipDepth = 0; // open containers inside a skipped value
+    bool m_descend = false; // Admit's decision for the container being opened
+};
+
+// Second stage of the fast load: walks the token offsets from json_scan::FindStructurals and
+// builds the same tree Importer would. Returns false on anything it does not accept, without
+// saying why; the caller then parses again with nlohmann, so errors keep their types and
+// messages.
+class StructuralImporter
+{
+public:
+    StructuralImporter(const char* text, const size_t size, const json_scan::Structurals& structurals,
+        MappingNode& root, std::shared_ptr<StringArena> arena, const bool packNumbers)
+        : m_text(text), m_size(size), m_structurals(structurals), m_root(root), m_arena(std::move(arena)),
+        m_packNumbers(packNumbers) {}
+
+    bool Run()
+    {
+        enum class Expect { Value, ValueOrClose, Key, KeyOrClose, Colon, CommaOrClose, End };
+
+        Expect expect = Expect::Value;
+        for (m_index = 0; m_index < m_structurals.Size(); ++m_index)
+        {
+            const char c = m_text[m_structurals[m_index]];
+            if ((c == '}' || c == ']') &&
+                (expect == Expect::CommaOrClose || expect == Expect::KeyOrClose || expect == Expect::ValueOrClose))
             {
-                out = in.get<int32_t>();
-                return;
+                if (m_stack.back().isObject != (c == '}'))
+                    return false;
+                m_stack.pop_back();
+                expect = (m_stack.empty()) ? Expect::End : Expect::CommaOrClose;
+                continue;
             }
-            out = in.get<int64_t>();
-            return;
+
+            switch (expect)
+            {
+            case Expect::End:
+                return false;
+            case Expect::Colon:
+                if (c != ':')
+                    return false;
+                expect = Expect::Value;
+                continue;
+            case Expect::CommaOrClose:
+                if (c != ',')
+                    return false;
+                expect = (m_stack.back().isObject) ? Expect::Key : Expect::Value;
+                continue;
+            case Expect::Key:
+            case Expect::KeyOrClose:
+            {
+                std::string_view key;
+                if (c != '"' || !StringToken(key))
+                    return false;
+                m_key.assign(key.data(), key.size());
+                expect = Expect::Colon;
+                continue;
+            }
+            default:
+                break;
+            }
+
+            if (c == '{' || c == '[')
+            {
+                MappingNode& node = Next();
+                if (c == '[' && m_packNumbers && PackedArray(node))
+                {
+                    expect = (m_stack.empty()) ? Expect::End : Expect::CommaOrClose;
+                    continue;
+                }
+                m_stack.push_back({ &node, c == '{' });
+                expect = (c == '{') ? Expect::KeyOrClose : Expect::ValueOrClose;
+                continue;
+            }
+            if (!Scalar(c, Next()))
+                return false;
+            expect = (m_stack.empty()) ? Expect::End : Expect::CommaOrClose;
         }
+        return expect == Expect::End;
+    }
 
-        if (in.is_number_unsigned() && in.get<uint64_t>() <= std::numeric_limits<uint32_t>::max())
+private:
+    struct Container
+    {
+        MappingNode* node;
+        bool isObject;
+    };
+
+    // End of the current token: the last byte before the next one that is not whitespace
+    size_t TokenEnd() const
+    {
+        return TokenEnd(m_index);
+    }
+
+    size_t TokenEnd(const size_t index) const
+    {
+        const size_t begin = m_structurals[index];
+        size_t end = (index + 1 < m_structurals.Size()) ? m_structurals[index + 1] : m_size;
+        while (end > begin && (m_text[end - 1] == ' ' || m_text[end - 1] == '\n' ||
+            m_text[end - 1] == '\r' || m_text[end - 1] == '\t'))
         {
-            out = in.get<uint32_t>();
-            return;
+            --end;
         }
-        out = in.get<uint64_t>();
-        return;
+        return end;
     }
 
-    out = in.get<std::string>();
+    // Contents of the current string token, unescaped into m_scratch when it has escapes
+    bool StringToken(std::string_view& out)
+    {
+        const size_t begin = m_structurals[m_index];
+        const size_t end = TokenEnd();
+        if (end - begin < 2 || m_text[end - 1] != '"')
+            return false;
+
+        out = std::string_view(m_text + begin + 1, end - begin - 2);
+        if (json_scan::FindBackslash(out.data(), out.size()) == out.size())
+            return true;
+
+        m_scratch.clear();
+        if (json_text::TryUnescape(out, m_scratch))
+            return false;
+        out = m_scratch;
+        return true;
+    }
+
+    bool Scalar(const char c, MappingNode& node)
+    {
+        if (c == '"')
+        {
+            std::string_view value;
+            if (!StringToken(value))
+                return false;
+            if (m_arena)
+                node.SetBorrowedString(StringArena::Borrow(m_arena, value));
+            else
+                node = value;
+            return true;
+        }
+
+        const size_t begin = m_structurals[m_index];
+        const std::string_view token(m_text + begin, TokenEnd() - begin);
+        if (token == "null")
+            return true;
+        if (token == "true" || token == "false")
+        {
+            node = (token[0] == 't');
+            return true;
+        }
+        return Number(token, node);
+    }
+
+    // Loads the array opening at m_index as one packed node if it holds nothing but numbers a
+    // double represents as read, leaving m_index on its ']'. Otherwise nothing is consumed.
+    bool PackedArray(MappingNode& node)
+    {
+        m_values.clear();
+        for (size_t index = m_index + 1; index < m_structurals.Size(); index += 2)
+        {
+            const size_t begin = m_structurals[index];
+            const std::string_view token(m_text + begin, TokenEnd(index) - begin);
+            double value;
+            if (!json_text::IsNumber(token) || !NumberFormat::ParseExactDouble(token, value))
+                return false;
+            m_values.push_back(value);
+
+            if (index + 1 >= m_structurals.Size())
+                return false;
+            const char next = m_text[m_structurals[index + 1]];
+            if (next == ']')
+            {
+                node.SetPackedArray(m_values);
+                m_index = index + 1;
+                return true;
+            }
+            if (next != ',')
+                return false;
+        }
+        return false;
+    }
+
+    // Narrowed as Importer does; integers past 64 bits are decimals to nlohmann, and here
+    static bool Number(const std::string_view text, MappingNode& node)
+    {
+        if (!json_text::IsNumber(text))
+            return false;
+
+        if (text.find_first_of(".eE") == std::string_view::npos)
+        {
+            if (text[0] == '-')
+            {
+                int64_t value;
+                if (NumberFormat::Parse(text, value))
+                {
+                    if (value >= std::numeric_limits<int32_t>::min())
+                        node = static_cast<int32_t>(value);
+                    else
+                        node = value;
+                    return true;
+                }
+            }
+            else
+            {
+                uint64_t value;
+                if (NumberFormat::Parse(text, value))
+                {
+                    if (value <= std::numeric_limits<uint32_t>::max())
+                        node = static_cast<uint32_t>(value);
+                    else
+                        node = value;
+                    return true;
+                }
+            }
+        }
+
+        if (!FitsDouble(text))
+            return false;
+        node.SetRawNumber(text);
+        return true;
+    }
+
+    // Whether the magnitude is certainly below DBL_MAX. nlohmann rejects decimals that
+    // overflow; anything near the limit is left to it.
+    static bool FitsDouble(const std::string_view text)
+    {
+        size_t i = (text[0] == '-') ? 1 : 0;
+        while (i < text.size() && text[i] == '0')
+            ++i;
+
+        long digits = 0; // before the point, without leading zeros
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i)
+            ++digits;
+        while (i < text.size() && text[i] != 'e' && text[i] != 'E')
+            ++i;
+
+        long exponent = 0;
+        if (i < text.size())
+        {
+            bool negative = false;
+            if (text[++i] == '+' || text[i] == '-')
+                negative = (text[i++] == '-');
+            while (i < text.size() && exponent < 10000)
+                exponent = exponent * 10 + (text[i++] - '0');
+            if (negative)
+                exponent = -exponent;
+        }
+        return digits + exponent <= 308;
+    }
+
+    MappingNode& Next()
+    {
+        if (m_stack.empty())
+        {
+            return m_root;
+        }
+
+        MappingNode& parent = *m_stack.back().node;
+        if (m_stack.back().isObject)
+        {
+            // A repeated key takes the last value
+            MappingNode& child = parent[m_key];
+            child.Clear();
+            return child;
+        }
+        parent.PushBack(MappingNode());
+        return parent[parent.Size() - 1];
+    }
+
+    const char* m_text;
+    size_t m_size;
+    const json_scan::Structurals& m_structurals;
+    size_t m_index = 0;
+    MappingNode& m_root;
+    std::shared_ptr<StringArena> m_arena;
+    std::vector<Container> m_stack;
+    std::string m_key;
+    std::string m_scratch;
+    const bool m_packNumbers;
+    std::vector<double> m_values;
+};
+}
+
+// Vectorized load for the common case. False if either stage gave up, with 'result' cleared
+// for the nlohmann parse that then runs.
+static bool FastImport(const char* data, const size_t size, MappingNode& result, const std::shared_ptr<StringArena>& arena,
+    const bool packNumbers)
+{
+    json_scan::Structurals structurals;
+    if (json_scan::FindStructurals(data, size, structurals) &&
+        StructuralImporter(data, size, structurals, result, arena, packNumbers).Run())
+    {
+        return true;
+    }
+    result.Clear();
+    return false;
 }
 
 static void Export(json& out, const MappingNode& in)
 {
+    if (!in.IsDefined())
+    {
+        out = nullptr;
+        return;
+    }
+
     if (in.IsMapping())
     {
         for (const MappingNode& child : in)
@@ -166,26 +675,242 @@ static void Export(json& out, const MappingNode& in)
     out = in.As<std::string>();
 }
 
+namespace
+{
+// Writes the same text as json::dump (raw numbers aside, which keep their source text). In
+// incremental mode it copies container subtrees found in the previous output instead of
+// serializing them again.
+struct Writer
+{
+    // Smaller subtrees are cheaper to rewrite than to index
+    static constexpr size_t s_minSpan = 64;
+
+    const std::string& previous;
+    const std::vector<JSONFormatter::CachedSpan>& spans;
+    const std::unordered_map<uint64_t, size_t>& spanIndex;
+    const bool incremental;
+    const bool pretty;
+
+    std::string& out;
+    std::vector<JSONFormatter::CachedSpan> nextSpans;
+
+    void Indent(const size_t depth)
+    {
+        out.append(depth * 4, ' ');
+    }
+
+    void WriteString(const std::string_view text)
+    {
+        const size_t start = out.size();
+        if (!json_text::AppendQuoted(out, text))
+        {
+            // Not UTF-8: json::dump throws its usual type_error
+            out.resize(start);
+            out += json(std::string(text)).dump();
+        }
+    }
+
+    // As json::dump writes what Export gives it. A float is widened to double first: its own
+    // shortest digits would read back as a different double, while these narrow back to the
+    // same float on load (see MappingNode::ParseNumber).
+    void WriteNumber(const MappingNode& node)
+    {
+        if (node.HasDecimal())
+        {
+            const double value = node.As<double>();
+            if (!std::isfinite(value))
+            {
+                out += "null";
+                return;
+            }
+            NumberFormat::Append(out, value);
+            return;
+        }
+
+        if (node.IsNegative())
+            NumberFormat::Append(out, node.As<int64_t>());
+        else
+            NumberFormat::Append(out, node.As<uint64_t>());
+    }
+
+    // An element of a packed array, written as the node it unpacks to would be
+    void WritePacked(const double value)
+    {
+        if (MappingNode::StoresAsInteger(value))
+            NumberFormat::Append(out, static_cast<int64_t>(value));
+        else
+            NumberFormat::Append(out, value);
+    }
+
+    // Guards a hash match against a collision: the span must hold a container of the same
+    // type and element count
+    bool Matches(const JSONFormatter::CachedSpan& span, const MappingNode& node) const
+    {
+        const char open = (node.IsMapping()) ? '{' : '[';
+        const char close = (node.IsMapping()) ? '}' : ']';
+        return span.isMapping == node.IsMapping() && span.size == node.Size() &&
+            span.length >= 2 && span.offset + span.length <= previous.size() &&
+            previous[span.offset] == open && previous[span.offset + span.length - 1] == close;
+    }
+
+    void Write(const MappingNode& node, const size_t depth)
+    {
+        if (node.IsRawNumber() && json_text::IsNumber(node.RawNumber()))
+        {
+            out += node.RawNumber();
+            return;
+        }
+
+        if (node.IsString())
+        {
+            WriteString(node.AsStringView());
+            return;
+        }
+
+        if (node.IsNumeric())
+        {
+            WriteNumber(node);
+            return;
+        }
+
+        if (node.IsBinary())
+        {
+            // The alphabet needs no escaping
+            const ByteSpan bytes = node.AsBytes();
+            out += '"';
+            Base64::Encode(bytes.data(), bytes.size(), out);
+            out += '"';
+            return;
+        }
+
+        // Export turns empty containers into null as well
+        if ((!node.IsMapping() && !node.IsArray()) || node.Size() == 0)
+        {
+            json value;
+            Export(value, node);
+            out += value.dump();
+            return;
+        }
+
+        const size_t start = out.size();
+        const size_t slot = nextSpans.size();
+        if (incremental)
+        {
+            uint64_t key = node.Hash();
+            if (pretty)
+            {
+                key = HashBytes(&depth, sizeof(depth), key);
+            }
+
+            auto it = spanIndex.find(key);
+            if (it != spanIndex.end() && Matches(spans[it->second], node))
+            {
+                // Nested spans start inside this one and directly follow it in offset order
+                const JSONFormatter::CachedSpan& span = spans[it->second];
+                for (size_t i = it->second; i < spans.size() && spans[i].offset < span.offset + span.length; ++i)
+                {
+                    JSONFormatter::CachedSpan nested = spans[i];
+                    nested.offset = spans[i].offset - span.offset + out.size();
+                    nextSpans.push_back(nested);
+                }
+                out.append(previous, span.offset, span.length);
+                return;
+            }
+            nextSpans.push_back({ key, start, 0, node.Size(), node.IsMapping() });
+        }
+
+        if (node.IsMapping())
+        {
+            // json objects are ordered by key
+            std::vector<const MappingNode*> children;
+            children.reserve(node.Size());
+            for (const MappingNode& child : node)
+            {
+                children.push_back(&child);
+            }
+            std::sort(children.begin(), children.end(),
+                [](const MappingNode* a, const MappingNode* b) { return a->Key() < b->Key(); });
+
+            out += (pretty) ? "{\n" : "{";
+            for (size_t i = 0; i < children.size(); ++i)
+            {
+                if (i > 0)
+                {
+                    out += (pretty) ? ",\n" : ",";
+                }
+                if (pretty)
+                {
+                    Indent(depth + 1);
+                }
+                WriteString(children[i]->Key());
+                out += (pretty) ? ": " : ":";
+                Write(*children[i], depth + 1);
+            }
+            if (pretty)
+            {
+                out += '\n';
+                Indent(depth);
+            }
+            out += '}';
+        }
+        else
+        {
+            out += (pretty) ? "[\n" : "[";
+            for (size_t i = 0; i < node.Size(); ++i)
+            {
+                if (i > 0)
+                {
+                    out += (pretty) ? ",\n" : ",";
+                }
+                if (pretty)
+                {
+                    Indent(depth + 1);
+                }
+                if (node.IsPacked())
+                    WritePacked(node.PackedValues()[i]);
+                else
+                    Write(node[i], depth + 1);
+            }
+            if (pretty)
+            {
+                out += '\n';
+                Indent(depth);
+            }
+            out += ']';
+        }
+
+        if (incremental)
+        {
+            // Anything nested in a small subtree is smaller still, so the whole tail goes
+            nextSpans[slot].length = out.size() - start;
+            if (nextSpans[slot].length < s_minSpan)
+            {
+                nextSpans.resize(slot);
+            }
+        }
+    }
+};
+}
+
 MappingNode xe::JSONFormatter::LoadFile(const std::filesystem::path& path)
 {
-    std::ifstream file(path, std::ios::ate);
-    size_t length = file.tellg();
+    std::vector<uint8_t> content = FileIO::ReadFile(path);
 
-    if (length == 0)
+    if (content.empty())
         return MappingNode();
 
-    file.seekg(0, std::ios::beg);
-    std::vector<char> content(length + 1);
-    file.read(content.data(), length);
-    content.back() = '\0';
-    return LoadContent(content.data());
+    return LoadContent(content.data(), content.size());
 }
 
 MappingNode xe::JSONFormatter::LoadContent(const std::string& content)
 {
     MappingNode result;
-    json in = json::parse(content);
-    Import(in, result);
+    std::shared_ptr<StringArena> arena = (m_borrowStrings) ? std::make_shared<StringArena>() : nullptr;
+    if (FastImport(content.data(), content.size(), result, arena, m_packNumericArrays))
+        return result;
+
+    Importer importer(result, arena);
+    json::sax_parse(content, &importer);
     return result;
 }
 
@@ -193,29 +918,174 @@ MappingNode xe::JSONFormatter::LoadContent(const std::vector<uint8_t>& content)
 {
     if (content.empty() || content.back() != '\0')
     {
-        throw std::runtime_error("Content should be a string. Expected null termination character not found.");
+        XE_THROW(std::runtime_error("Content should be a string. Expected null termination character not found."));
     }
 
     return LoadContent((const char*)content.data());
 }
 
+MappingNode xe::JSONFormatter::LoadContent(const uint8_t* data, size_t size)
+{
+    MappingNode result;
+    std::shared_ptr<StringArena> arena = (m_borrowStrings) ? std::make_shared<StringArena>() : nullptr;
+    if (FastImport(reinterpret_cast<const char*>(data), size, result, arena, m_packNumericArrays))
+        return result;
+
+    Importer importer(result, arena);
+    json::sax_parse(data, data + size, &importer);
+    return result;
+}
+
+MappingNode xe::JSONFormatter::LoadContent(const uint8_t* data, size_t size, const Projection& projection)
+{
+    MappingNode result;
+    Projection::Walker walker(projection);
+    Importer importer(result, (m_borrowStrings) ? std::make_shared<StringArena>() : nullptr, nullptr, &walker);
+    json::sax_parse(data, data + size, &importer);
+    return result;
+}
+
+ParseResult xe::JSONFormatter::TryLoadContent(const uint8_t* data, size_t size)
+{
+    ParseResult result;
+    std::shared_ptr<StringArena> arena = (m_borrowStrings) ? std::make_shared<StringArena>() : nullptr;
+    if (FastImport(reinterpret_cast<const char*>(data), size, result.node, arena, m_packNumericArrays))
+        return result;
+
+    Importer importer(result.node, arena, &result.error);
+    if (!json::sax_parse(data, data + size, &importer))
+    {
+        result.node.Clear();
+        result.error.Locate(std::string_view(reinterpret_cast<const char*>(data), size), result.error.offset);
+    }
+    return result;
+}
+
+JSONDocument xe::JSONFormatter::LoadLazyFile(const std::filesystem::path& path) const
+{
+    std::vector<uint8_t> content = FileIO::ReadFile(path);
+    return JSONDocument(content.data(), content.size());
+}
+
+std::optional<JSONDocument> xe::JSONFormatter::TryLoadLazyFile(const std::filesystem::path& path, ParseError* out_error) const
+{
+    std::vector<FileRead> reads(1);
+    reads[0].path = path;
+    FileIO::Read(reads);
+    if (reads[0].error)
+    {
+        if (out_error)
+        {
+            *out_error = ParseError();
+            out_error->code = ParseError::Code::FileAccess;
+            out_error->message = "Could not open file: " + path.string();
+        }
+        return std::nullopt;
+    }
+    const std::vector<uint8_t>& content = reads[0].content;
+    return JSONDocument::TryParse(std::string(content.begin(), content.end()), out_error);
+}
+
 bool xe::JSONFormatter::SaveFile(const MappingNode& node, const std::filesystem::path& path)
 {
     std::string content;
     SaveContent(node, content);
-    std::ofstream file(path);
-    if (!file.is_open())
-        return false;
+    return FileIO::WriteFile(path, content.data(), content.length());
+}
+
+struct xe::JSONFormatter::Incremental
+{
+    std::mutex mutex; // guards the members below
+    std::string previous;
+    bool previousPretty = false;
+    std::vector<CachedSpan> spans; // ordered by offset
+    std::unordered_map<uint64_t, size_t> spanIndex; // key -> spans index
+
+    void Clear()
+    {
+        previous.clear();
+        spans.clear();
+        spanIndex.clear();
+    }
+};
+
+xe::JSONFormatter::JSONFormatter() : m_cache(std::make_unique<Incremental>())
+{
+}
+
+xe::JSONFormatter::JSONFormatter(const bool usePrettyFormat)
+    : m_usePrettyFormat(usePrettyFormat), m_cache(std::make_unique<Incremental>())
+{
+}
+
+xe::JSONFormatter::JSONFormatter(const JSONFormatter& other)
+    : IFormatter(other), m_usePrettyFormat(other.m_usePrettyFormat), m_incremental(other.m_incremental),
+    m_cache(std::make_unique<Incremental>())
+{
+}
+
+JSONFormatter& xe::JSONFormatter::operator=(const JSONFormatter& other)
+{
+    if (this != &other)
+    {
+        IFormatter::operator=(other);
+        m_usePrettyFormat = other.m_usePrettyFormat;
+        m_incremental = other.m_incremental;
+        Incremental& cache = Cache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.Clear();
+    }
+    return *this;
+}
+
+xe::JSONFormatter::JSONFormatter(JSONFormatter&& other) noexcept = default;
+JSONFormatter& xe::JSONFormatter::operator=(JSONFormatter&& other) noexcept = default;
+xe::JSONFormatter::~JSONFormatter() = default;
+
+// Only a moved-from formatter has none
+xe::JSONFormatter::Incremental& xe::JSONFormatter::Cache()
+{
+    if (!m_cache)
+    {
+        m_cache = std::make_unique<Incremental>();
+    }
+    return *m_cache;
+}
 
-    file << content;
-    return true;
+void xe::JSONFormatter::SetIncremental(const bool incremental)
+{
+    Incremental& cache = Cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    m_incremental = incremental;
+    cache.Clear();
 }
 
 void xe::JSONFormatter::SaveContent(const MappingNode& node, std::string& out_content)
 {
-    json out;
-    Export(out, node);
-    out_content = out.dump((m_usePrettyFormat) ? 4 : -1);
+    Incremental& cache = Cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (m_incremental && cache.previousPretty != m_usePrettyFormat)
+    {
+        // Spans from the other layout do not apply
+        cache.Clear();
+        cache.previousPretty = m_usePrettyFormat;
+    }
+
+    out_content.clear();
+    out_content.reserve(cache.previous.size());
+    Writer writer{ cache.previous, cache.spans, cache.spanIndex, m_incremental, m_usePrettyFormat, out_content, {} };
+    writer.Write(node, 0);
+
+    if (m_incremental)
+    {
+        cache.previous = out_content;
+        cache.spans = std::move(writer.nextSpans);
+        cache.spanIndex.clear();
+        for (size_t i = 0; i < cache.spans.size(); ++i)
+        {
+            cache.spanIndex.emplace(cache.spans[i].key, i);
+        }
+    }
 }
 
 void xe::JSONFormatter::SaveContent(const MappingNode& node, std::vector<uint8_t>& out_content)
@@ -224,6 +1094,6 @@ void xe::JSONFormatter::SaveContent(const MappingNode& node, std::vector<uint8_t
     SaveContent(node, contentStr);
     out_content.clear();
     out_content.resize(contentStr.length() + 1);
-    memcpy_s(out_content.data(), contentStr.length(), contentStr.c_str(), contentStr.length());
+    std::memcpy(out_content.data(), contentStr.c_str(), contentStr.length());
     out_content.back() = 0;
 }
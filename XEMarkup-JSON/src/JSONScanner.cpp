@@ -0,0 +1,444 @@
+/*========================================================
+
+ XEMarkup - JSON Scanner
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#include "JSONScanner.h"
+
+#include <XEMarkup/CPUFeatures.h>
+#include <XEMarkup/Utf8.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace xe::json_scan;
+
+namespace
+{
+// One bit per byte of a 64-byte block
+struct Masks
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op; // { } [ ] : ,
+    uint64_t space;
+    uint64_t control; // below 0x20
+};
+}
+
+static int TrailingZeros(const uint64_t bits)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+static Masks ClassifyScalar(const uint8_t* in)
+{
+    Masks m{};
+    for (int i = 0; i < 64; ++i)
+    {
+        const uint8_t c = in[i];
+        const uint64_t bit = 1ull << i;
+        switch (c)
+        {
+        case '"': m.quote |= bit; break;
+        case '\\': m.backslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+        case ' ': case '\t': case '\n': case '\r': m.space |= bit; break;
+        default: break;
+        }
+        if (c < 0x20) m.control |= bit;
+    }
+    return m;
+}
+
+// The vector paths find { } [ ] by setting bit 5 first, which folds [ onto { and ] onto }
+
+#ifdef XE_SIMD_X86
+static uint64_t Bits(const __m128i lanes)
+{
+    return static_cast<uint32_t>(_mm_movemask_epi8(lanes));
+}
+
+static __m128i Equal(const __m128i lanes, const char c)
+{
+    return _mm_cmpeq_epi8(lanes, _mm_set1_epi8(c));
+}
+
+static Masks ClassifySSE2(const uint8_t* in)
+{
+    Masks m{};
+    for (int k = 0; k < 4; ++k)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * k));
+        const __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        const int shift = 16 * k;
+
+        m.quote |= Bits(Equal(v, '"')) << shift;
+        m.backslash |= Bits(Equal(v, '\\')) << shift;
+        m.op |= Bits(_mm_or_si128(_mm_or_si128(Equal(folded, '{'), Equal(folded, '}')),
+            _mm_or_si128(Equal(v, ':'), Equal(v, ',')))) << shift;
+        m.space |= Bits(_mm_or_si128(_mm_or_si128(Equal(v, ' '), Equal(v, '\t')),
+            _mm_or_si128(Equal(v, '\n'), Equal(v, '\r')))) << shift;
+        m.control |= Bits(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v)) << shift;
+    }
+    return m;
+}
+
+XE_TARGET_AVX2 static uint64_t Bits(const __m256i lanes)
+{
+    return static_cast<uint32_t>(_mm256_movemask_epi8(lanes));
+}
+
+XE_TARGET_AVX2 static __m256i Equal(const __m256i lanes, const char c)
+{
+    return _mm256_cmpeq_epi8(lanes, _mm256_set1_epi8(c));
+}
+
+XE_TARGET_AVX2 static Masks ClassifyAVX2(const uint8_t* in)
+{
+    Masks m{};
+    for (int k = 0; k < 2; ++k)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 32 * k));
+        const __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        const int shift = 32 * k;
+
+        m.quote |= Bits(Equal(v, '"')) << shift;
+        m.backslash |= Bits(Equal(v, '\\')) << shift;
+        m.op |= Bits(_mm256_or_si256(_mm256_or_si256(Equal(folded, '{'), Equal(folded, '}')),
+            _mm256_or_si256(Equal(v, ':'), Equal(v, ',')))) << shift;
+        m.space |= Bits(_mm256_or_si256(_mm256_or_si256(Equal(v, ' '), Equal(v, '\t')),
+            _mm256_or_si256(Equal(v, '\n'), Equal(v, '\r')))) << shift;
+        m.control |= Bits(_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1F)), v)) << shift;
+    }
+    return m;
+}
+#endif // XE_SIMD_X86
+
+#ifdef XE_SIMD_NEON
+// NEON has no movemask: weight each lane by its bit and add neighbours until 64 lanes are 8 bytes
+static uint64_t Bits(const uint8x16_t (&lanes)[4])
+{
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t weight = vld1q_u8(weights);
+
+    uint8x16_t low = vpaddq_u8(vandq_u8(lanes[0], weight), vandq_u8(lanes[1], weight));
+    const uint8x16_t high = vpaddq_u8(vandq_u8(lanes[2], weight), vandq_u8(lanes[3], weight));
+    low = vpaddq_u8(low, high);
+    low = vpaddq_u8(low, low);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(low), 0);
+}
+
+static uint8x16_t Equal(const uint8x16_t lanes, const uint8_t c)
+{
+    return vceqq_u8(lanes, vdupq_n_u8(c));
+}
+
+static Masks ClassifyNEON(const uint8_t* in)
+{
+    uint8x16_t quote[4], backslash[4], op[4], space[4], control[4];
+    for (int k = 0; k < 4; ++k)
+    {
+        const uint8x16_t v = vld1q_u8(in + 16 * k);
+        const uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(0x20));
+
+        quote[k] = Equal(v, '"');
+        backslash[k] = Equal(v, '\\');
+        op[k] = vorrq_u8(vorrq_u8(Equal(folded, '{'), Equal(folded, '}')), vorrq_u8(Equal(v, ':'), Equal(v, ',')));
+        space[k] = vorrq_u8(vorrq_u8(Equal(v, ' '), Equal(v, '\t')), vorrq_u8(Equal(v, '\n'), Equal(v, '\r')));
+        control[k] = vcltq_u8(v, vdupq_n_u8(0x20));
+    }
+    return { Bits(quote), Bits(backslash), Bits(op), Bits(space), Bits(control) };
+}
+#endif // XE_SIMD_NEON
+
+// Bits of the bytes a backslash escapes. 'carry' is set when the block's last byte is an
+// unescaped backslash, escaping the first byte of the next block.
+static uint64_t FindEscaped(uint64_t backslash, uint64_t& carry)
+{
+    uint64_t escaped = carry;
+    backslash &= ~carry; // an escaped backslash escapes nothing
+    carry = 0;
+    while (backslash)
+    {
+        const int i = TrailingZeros(backslash);
+        if (i == 63)
+        {
+            carry = 1;
+            break;
+        }
+        escaped |= 2ull << i;
+        backslash &= ~(3ull << i);
+    }
+    return escaped;
+}
+
+// Bit i is the parity of bits 0..i: set from an opening quote up to, not including, its closing one
+static uint64_t PrefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+template <Masks (*Classify)(const uint8_t*)>
+static bool Scan(const char* data, const size_t size, Structurals& out)
+{
+    out.Clear();
+    if (size > std::numeric_limits<uint32_t>::max())
+        return false;
+    out.Reserve(size / 4 + 64);
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    uint64_t escapeCarry = 0;
+    uint64_t stringCarry = 0; // all ones while a string is open across blocks
+    uint64_t scalarCarry = 0;
+
+    uint8_t tail[64];
+    for (size_t base = 0; base < size; base += 64)
+    {
+        const size_t length = std::min<size_t>(64, size - base);
+        const uint8_t* block = bytes + base;
+        if (length < 64)
+        {
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, length);
+            block = tail;
+        }
+
+        const Masks m = Classify(block);
+        const uint64_t quotes = m.quote & ~FindEscaped(m.backslash, escapeCarry);
+        const uint64_t inString = PrefixXor(quotes) ^ stringCarry;
+        stringCarry = 0 - (inString >> 63);
+
+        if (m.control & inString)
+            return false;
+
+        // A scalar starts at any other byte not preceded by one
+        const uint64_t scalar = ~(m.op | m.space | m.quote);
+        const uint64_t scalarStart = scalar & ~((scalar << 1) | scalarCarry);
+        scalarCarry = scalar >> 63;
+
+        uint64_t structurals = ((m.op | scalarStart) & ~inString) | (quotes & inString);
+
+        uint32_t* offsets = out.Reserve(64);
+        while (structurals)
+        {
+            *offsets++ = static_cast<uint32_t>(base) + static_cast<uint32_t>(TrailingZeros(structurals));
+            structurals &= structurals - 1;
+        }
+        out.Commit(offsets);
+    }
+
+    return stringCarry == 0;
+}
+
+// String kernels: the offset of the first byte a JSON string cannot hold as it is (a quote,
+// backslash, control or non-ASCII byte), or with 'backslashOnly' of the first backslash
+
+template <bool backslashOnly>
+static bool IsStop(const char c)
+{
+    const uint8_t byte = static_cast<uint8_t>(c);
+    return byte == '\\' || (!backslashOnly && (byte == '"' || byte < 0x20 || byte >= 0x80));
+}
+
+template <bool backslashOnly>
+static size_t FindStopScalar(const char* data, const size_t size, size_t i = 0)
+{
+    for (; i < size; ++i)
+    {
+        if (IsStop<backslashOnly>(data[i]))
+            return i;
+    }
+    return size;
+}
+
+#ifdef XE_SIMD_X86
+template <bool backslashOnly>
+static size_t FindStopSSE2(const char* data, const size_t size)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i stop = Equal(v, '\\');
+        if constexpr (!backslashOnly)
+        {
+            // Signed, so bytes from 0x80 up are below 0x20 as well
+            stop = _mm_or_si128(_mm_or_si128(stop, Equal(v, '"')), _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+        }
+        if (const uint64_t bits = Bits(stop))
+            return i + static_cast<size_t>(TrailingZeros(bits));
+    }
+    return FindStopScalar<backslashOnly>(data, size, i);
+}
+
+template <bool backslashOnly>
+XE_TARGET_AVX2 static size_t FindStopAVX2(const char* data, const size_t size)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i stop = Equal(v, '\\');
+        if constexpr (!backslashOnly)
+        {
+            stop = _mm256_or_si256(_mm256_or_si256(stop, Equal(v, '"')), _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+        }
+        if (const uint64_t bits = Bits(stop))
+            return i + static_cast<size_t>(TrailingZeros(bits));
+    }
+
+    // Not handed to another function: calling non-AVX code with the upper halves of the
+    // registers dirty is slow on many CPUs
+    for (; i < size; ++i)
+    {
+        if (IsStop<backslashOnly>(data[i]))
+            return i;
+    }
+    return size;
+}
+#endif // XE_SIMD_X86
+
+#ifdef XE_SIMD_NEON
+template <bool backslashOnly>
+static size_t FindStopNEON(const char* data, const size_t size)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t stop = Equal(v, '\\');
+        if constexpr (!backslashOnly)
+        {
+            stop = vorrq_u8(vorrq_u8(stop, Equal(v, '"')),
+                vorrq_u8(vcltq_u8(v, vdupq_n_u8(0x20)), vcgeq_u8(v, vdupq_n_u8(0x80))));
+        }
+
+        // Narrowing by 4 leaves four bits per lane
+        const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(stop), 4);
+        if (const uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0))
+            return i + static_cast<size_t>(TrailingZeros(bits)) / 4;
+    }
+    return FindStopScalar<backslashOnly>(data, size, i);
+}
+#endif // XE_SIMD_NEON
+
+static bool Available(const Path path)
+{
+    switch (path)
+    {
+    case Path::Scalar:
+        return true;
+#ifdef XE_SIMD_X86
+    case Path::SSE2:
+        return true;
+    case Path::AVX2:
+        return xe::CPUFeatures::HasAVX2();
+#endif
+#ifdef XE_SIMD_NEON
+    case Path::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+Path xe::json_scan::BestPath()
+{
+    for (const Path path : { Path::AVX2, Path::NEON, Path::SSE2 })
+    {
+        if (Available(path))
+            return path;
+    }
+    return Path::Scalar;
+}
+
+bool xe::json_scan::FindStructurals(const char* data, const size_t size, Structurals& out, Path path)
+{
+    static const Path best = BestPath();
+    if (path == Path::Auto || !Available(path))
+        path = best;
+
+    // Checked in a pass of its own first, so the scan and the importer after it take the
+    // bytes inside strings as they come
+    if (!Utf8::IsValid(data, size, (path == Path::Scalar) ? Utf8::Path::Scalar : Utf8::Path::Auto))
+    {
+        out.Clear();
+        return false;
+    }
+
+    switch (path)
+    {
+#ifdef XE_SIMD_X86
+    case Path::AVX2: return Scan<ClassifyAVX2>(data, size, out);
+    case Path::SSE2: return Scan<ClassifySSE2>(data, size, out);
+#endif
+#ifdef XE_SIMD_NEON
+    case Path::NEON: return Scan<ClassifyNEON>(data, size, out);
+#endif
+    default: return Scan<ClassifyScalar>(data, size, out);
+    }
+}
+
+using Finder = size_t (*)(const char*, size_t);
+
+template <bool backslashOnly>
+static Finder SelectFinder()
+{
+    switch (BestPath())
+    {
+#ifdef XE_SIMD_X86
+    case Path::AVX2: return FindStopAVX2<backslashOnly>;
+    case Path::SSE2: return FindStopSSE2<backslashOnly>;
+#endif
+#ifdef XE_SIMD_NEON
+    case Path::NEON: return FindStopNEON<backslashOnly>;
+#endif
+    default: return [](const char* data, const size_t size) { return FindStopScalar<backslashOnly>(data, size); };
+    }
+}
+
+size_t xe::json_scan::PlainLength(const char* data, const size_t size)
+{
+    static const Finder find = SelectFinder<false>();
+    return find(data, size);
+}
+
+size_t xe::json_scan::FindBackslash(const char* data, const size_t size)
+{
+    static const Finder find = SelectFinder<true>();
+    return find(data, size);
+}
@@ -0,0 +1,97 @@
+/*========================================================
+
+ XEMarkup - JSON Scanner
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_JSONSCANNER_H
+#define XE_JSONSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Vectorized scanning of JSON text: the first stage of the fast load, which finds where every
+// token starts 64 bytes at a time, and the string kernels the reader and writer share
+namespace xe::json_scan
+{
+    enum class Path : uint8_t
+    {
+        Auto, // the widest the CPU supports
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON,
+    };
+
+    // Offsets of the tokens in a text, in order. Grows without initializing, since it is
+    // written once per token and can run to a few bytes per input byte.
+    class Structurals
+    {
+    public:
+        size_t Size() const noexcept { return m_size; }
+        uint32_t operator[](const size_t index) const noexcept { return m_offsets[index]; }
+
+        // Room for at least 'count' more offsets past Size(); returns where they go
+        uint32_t* Reserve(const size_t count)
+        {
+            if (m_size + count > m_capacity)
+            {
+                const size_t capacity = (m_size + count > 2 * m_capacity) ? m_size + count : 2 * m_capacity;
+                std::unique_ptr<uint32_t[]> offsets(new uint32_t[capacity]);
+                for (size_t i = 0; i < m_size; ++i)
+                    offsets[i] = m_offsets[i];
+                m_offsets = std::move(offsets);
+                m_capacity = capacity;
+            }
+            return m_offsets.get() + m_size;
+        }
+
+        // Takes the offsets written after a Reserve, up to 'end'
+        void Commit(const uint32_t* end) noexcept { m_size = static_cast<size_t>(end - m_offsets.get()); }
+
+        void Clear() noexcept { m_size = 0; }
+
+    private:
+        std::unique_ptr<uint32_t[]> m_offsets;
+        size_t m_size = 0;
+        size_t m_capacity = 0;
+    };
+
+    // Fills 'out' with the offset of every structural character ({ } [ ] : ,), every opening
+    // quote and the first byte of every other scalar, in order, outside of strings. Returns
+    // false for text that is certainly not valid JSON: a string left open, a control character
+    // inside a string, malformed UTF-8, or more than 4 GiB. Anything else is left to the caller.
+    // A path the build or the CPU lacks is replaced by the best one available.
+    bool FindStructurals(const char* data, size_t size, Structurals& out, Path path = Path::Auto);
+
+    // The path Path::Auto resolves to on this machine
+    Path BestPath();
+
+    // Length of the leading run that a JSON string holds as it is: no quote, backslash,
+    // control character or non-ASCII byte. Checks 32 or 16 bytes at a time.
+    size_t PlainLength(const char* data, size_t size);
+
+    // Offset of the first backslash, or 'size'
+    size_t FindBackslash(const char* data, size_t size);
+}
+
+#endif // !XE_JSONSCANNER_H
\ No newline at end of file
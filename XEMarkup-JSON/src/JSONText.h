@@ -0,0 +1,236 @@
+/*========================================================
+
+ XEMarkup - JSON Text
+ Copyright (C) 2024 Jon Bogert (jonbogert@gmail.com)
+
+ This software is provided 'as-is', without any express or implied warranty.
+ In no event will the authors be held liable for any damages arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it freely,
+ subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented;
+    you must not claim that you wrote the original software.
+    If you use this software in a product, an acknowledgment
+    in the product documentation would be appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such,
+    and must not be misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source distribution.
+
+========================================================*/
+
+#ifndef XE_JSONTEXT_H
+#define XE_JSONTEXT_H
+
+#include <XEMarkup/Exceptions.h>
+#include <XEMarkup/Utf8.h>
+
+#include "JSONScanner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Helpers for JSON source text shared by the formatter and the lazy document
+namespace xe::json_text
+{
+    // Whether 'text' is a number exactly as the JSON grammar allows it
+    inline bool IsNumber(const std::string_view text)
+    {
+        size_t i = 0;
+        auto digits = [&]()
+        {
+            size_t start = i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9')
+                ++i;
+            return i - start;
+        };
+
+        if (i < text.size() && text[i] == '-')
+            ++i;
+        size_t leading = digits();
+        if (leading == 0 || (leading > 1 && text[i - leading] == '0'))
+            return false;
+        if (i < text.size() && text[i] == '.')
+        {
+            ++i;
+            if (digits() == 0)
+                return false;
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E'))
+        {
+            ++i;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+                ++i;
+            if (digits() == 0)
+                return false;
+        }
+        return i == text.size();
+    }
+
+    inline void AppendUtf8(std::string& out, const uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    // Value of the four hex digits at 'at', or -1 if they are missing or not hex
+    inline int32_t TryReadHex4(const std::string_view text, const size_t at)
+    {
+        if (at + 4 > text.size())
+            return -1;
+
+        int32_t value = 0;
+        for (size_t i = at; i < at + 4; ++i)
+        {
+            const char c = text[i];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return -1;
+        }
+        return value;
+    }
+
+    // Decodes the contents of a string literal (without its quotes), appending to 'out'.
+    // Runs between escapes are copied whole. Returns nullptr on success and the reason otherwise.
+    inline const char* TryUnescape(const std::string_view text, std::string& out)
+    {
+        out.reserve(out.size() + text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const size_t run = json_scan::FindBackslash(text.data() + i, text.size() - i);
+            out.append(text.data() + i, run);
+            i += run;
+            if (i == text.size())
+                break;
+            if (++i == text.size())
+                return "Truncated escape in JSON string";
+
+            switch (text[i])
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                const int32_t high = TryReadHex4(text, i + 1);
+                if (high < 0)
+                    return (i + 5 > text.size()) ? "Truncated \\u escape in JSON string" : "Invalid \\u escape in JSON string";
+                uint32_t codePoint = static_cast<uint32_t>(high);
+                i += 4;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+                {
+                    // High surrogate: the low half must follow
+                    if (i + 6 >= text.size() || text[i + 1] != '\\' || text[i + 2] != 'u')
+                        return "Unpaired surrogate in JSON string";
+                    const int32_t low = TryReadHex4(text, i + 3);
+                    if (low < 0)
+                        return "Invalid \\u escape in JSON string";
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        return "Unpaired surrogate in JSON string";
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (static_cast<uint32_t>(low) - 0xDC00);
+                    i += 6;
+                }
+                else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+                {
+                    return "Unpaired surrogate in JSON string";
+                }
+                AppendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                return "Invalid escape in JSON string";
+            }
+        }
+        return nullptr;
+    }
+
+    inline void Unescape(const std::string_view text, std::string& out)
+    {
+        if (const char* error = TryUnescape(text, out))
+            XE_THROW(std::runtime_error(error));
+    }
+
+    // Appends 'text' as a string literal, escaped exactly as json::dump escapes it. Runs with
+    // nothing to escape are copied whole. Returns false, with 'out' partly written, if 'text'
+    // is not valid UTF-8.
+    inline bool AppendQuoted(std::string& out, const std::string_view text)
+    {
+        static const char hex[] = "0123456789abcdef";
+
+        out.reserve(out.size() + text.size() + 2);
+        out += '"';
+        for (size_t i = 0; i < text.size();)
+        {
+            const size_t run = json_scan::PlainLength(text.data() + i, text.size() - i);
+            out.append(text.data() + i, run);
+            i += run;
+            if (i == text.size())
+                break;
+
+            const uint8_t c = static_cast<uint8_t>(text[i]);
+            if (c >= 0x80)
+            {
+                const size_t length = Utf8::SequenceLength(text, i);
+                if (length == 0)
+                    return false;
+                out.append(text.data() + i, length);
+                i += length;
+                continue;
+            }
+
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+            }
+            ++i;
+        }
+        out += '"';
+        return true;
+    }
+}
+
+#endif // !XE_JSONTEXT_H
\ No newline at end of file
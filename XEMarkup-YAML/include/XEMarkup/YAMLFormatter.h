@@ -27,18 +27,30 @@
 
 #include <XEMarkup/IFormatter.h>
 
+#include <string_view>
+
 namespace xe
 {
 	class YAMLFormatter : public IFormatter
 	{
 	public:
 		MappingNode LoadFile(const std::filesystem::path& path) override;
+		using IFormatter::LoadFile;
 		MappingNode LoadContent(const std::string& content) override;
 		MappingNode LoadContent(const std::vector<uint8_t>& content) override;
+		MappingNode LoadContent(const uint8_t* data, size_t size) override;
+		MappingNode LoadContent(const uint8_t* data, size_t size, const Projection& projection) override;
+		using IFormatter::TryLoadContent;
+		ParseResult TryLoadContent(const uint8_t* data, size_t size) override;
 
 		bool SaveFile(const MappingNode& node, const std::filesystem::path& path) override;
 		void SaveContent(const MappingNode& node, std::string& out_content) override;
 		void SaveContent(const MappingNode& node, std::vector<uint8_t>& out_content) override;
+
+		// Loads every document in a multi-document stream ('---' separated), in order.
+		// Documents are parsed in parallel; threadCount of 0 uses the hardware concurrency.
+		std::vector<MappingNode> LoadAllFile(const std::filesystem::path& path, size_t threadCount = 0);
+		std::vector<MappingNode> LoadAllContent(std::string_view content, size_t threadCount = 0);
 	};
 }
 
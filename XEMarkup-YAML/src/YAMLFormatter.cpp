@@ -24,114 +24,468 @@
 
 #include "XEMarkup/YAMLFormatter.h"
 
+#include <XEMarkup/Base64.h>
+#include <XEMarkup/FileIO.h>
 #include <XEMarkup/MappingNode.h>
+#include <XEMarkup/NumberFormat.h>
+#include <XEMarkup/StringArena.h>
+#include <XEMarkup/Utf8.h>
 
+#include <yaml-cpp/eventhandler.h>
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdint>
-#include <fstream>
+#include <cstring>
+#include <exception>
 #include <limits>
-#include <regex>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace xe;
 
-static void Import(const YAML::Node& in, MappingNode& out)
+// true|false|yes|no|on|off in any case
+static bool IsBoolText(const std::string& content)
+{
+    static const char* const words[] = { "true", "false", "yes", "no", "on", "off" };
+    for (const char* word : words)
+    {
+        size_t length = std::strlen(word);
+        if (content.size() != length)
+            continue;
+
+        size_t i = 0;
+        while (i < length && (content[i] | 0x20) == word[i])
+            ++i;
+        if (i == length)
+            return true;
+    }
+    return false;
+}
+
+// -?\d*\.?\d+([eE][-+]?\d+)?
+static bool IsNumberText(const std::string& content)
+{
+    auto digits = [&](size_t& i)
+    {
+        size_t start = i;
+        while (i < content.size() && content[i] >= '0' && content[i] <= '9')
+            ++i;
+        return i - start;
+    };
+
+    size_t i = (!content.empty() && content[0] == '-') ? 1 : 0;
+    size_t whole = digits(i);
+    if (i < content.size() && content[i] == '.')
+    {
+        ++i;
+        if (digits(i) == 0)
+            return false;
+    }
+    else if (whole == 0)
+    {
+        return false;
+    }
+
+    if (i < content.size() && (content[i] == 'e' || content[i] == 'E'))
+    {
+        ++i;
+        if (i < content.size() && (content[i] == '-' || content[i] == '+'))
+            ++i;
+        if (digits(i) == 0)
+            return false;
+    }
+    return i == content.size();
+}
+
+// What yaml-cpp resolves !!binary to
+static constexpr const char* s_binaryTag = "tag:yaml.org,2002:binary";
+
+static void ImportScalar(const YAML::Mark& mark, const std::string& tag, const std::string& content, MappingNode& out,
+    const std::shared_ptr<StringArena>& arena)
+{
+    // BINARY: base64, often wrapped over lines
+    if (tag == s_binaryTag)
+    {
+        std::vector<uint8_t> bytes;
+        if (!Base64::Decode(content, bytes))
+            throw YAML::ParserException(mark, "invalid base64 in !!binary scalar");
+        out.SetBinary(std::move(bytes));
+        return;
+    }
+
+    // BOOL
+    if (IsBoolText(content))
+    {
+        out = YAML::Node(content).as<bool>();
+        return;
+    }
+
+    // NUMBER: kept as text until read (MappingNode::SetRawNumber)
+    if (IsNumberText(content))
+    {
+        out.SetRawNumber(content);
+        return;
+    }
+
+    // STRING
+    if (arena)
+    {
+        out.SetBorrowedString(StringArena::Borrow(arena, content));
+        return;
+    }
+    out = content;
+}
+
+// A non-empty sequence of numbers a double represents as read becomes one packed node
+// (MappingNode::SetPackedArray); false leaves 'out' untouched
+static bool ImportPacked(const YAML::Node& in, MappingNode& out)
+{
+    std::vector<double> values;
+    values.reserve(in.size());
+    for (const YAML::Node& child : in)
+    {
+        if (!child.IsScalar())
+            return false;
+
+        const std::string& content = child.Scalar();
+        double value;
+        if (!IsNumberText(content) || !NumberFormat::ParseExactDouble(content, value))
+            return false;
+        values.push_back(value);
+    }
+    if (values.empty())
+        return false;
+
+    out.SetPackedArray(std::move(values));
+    return true;
+}
+
+static void Import(const YAML::Node& in, MappingNode& out, const std::shared_ptr<StringArena>& arena, const bool packNumbers)
 {
     if (in.IsMap())
     {
         for (YAML::const_iterator it = in.begin(); it != in.end(); ++it)
         {
-            Import(it->second, out[it->first.as<std::string>()]);
+            Import(it->second, out[it->first.as<std::string>()], arena, packNumbers);
         }
         return;
     }
     if (in.IsSequence())
     {
+        if (packNumbers && ImportPacked(in, out))
+        {
+            return;
+        }
         for (const YAML::Node& child : in)
         {
             MappingNode result;
-            Import(child, result);
+            Import(child, result, arena, packNumbers);
             out.PushBack(result);
         }
         return;
     }
 
-    const std::string& content = in.Scalar();
-
-    // BOOL
-    static const std::regex boolRegex("^(true|false|yes|no|on|off)$", std::regex::icase);
-    if (std::regex_match(content, boolRegex))
+    if (in.IsNull())
     {
-        out = in.as<bool>();
         return;
     }
 
-    //INT
-    static const std::regex numberRegex("^-?\\d*\\.?\\d+([eE][-+]?\\d+)?$");
-    static const std::regex unsignedRegex("^\\d+$");
-    static const std::regex signedRegex("^-\\d+$");
+    ImportScalar(in.Mark(), in.Tag(), in.Scalar(), out, arena);
+}
 
-    if (std::regex_match(content, numberRegex))
+namespace
+{
+// Builds the tree from yaml-cpp's parse events for a projected load, so values the projection
+// does not select never become YAML::Nodes or MappingNodes. Anchored values are built even when
+// skipped, since a later alias may select them; an alias on the way to a selected path is
+// taken whole.
+class ProjectedImporter : public YAML::EventHandler
+{
+public:
+    ProjectedImporter(MappingNode& root, const Projection& projection, std::shared_ptr<StringArena> arena)
+        : m_root(root), m_walker(projection), m_arena(std::move(arena)) {}
+
+    void OnDocumentStart(const YAML::Mark&) override {}
+    void OnDocumentEnd() override {}
+
+    void OnNull(const YAML::Mark&, const YAML::anchor_t anchor) override
     {
-        if (std::regex_match(content, unsignedRegex) || std::regex_match(content, signedRegex))
+        if (IsKey())
         {
-            try
-            {
-                if (content[0] == '-')
-                {
-                    int64_t int64Val = std::stoll(content);
-                    if (int64Val >= std::numeric_limits<int32_t>::min() &&
-                        int64Val <= std::numeric_limits<int32_t>::max())
-                    {
-                        out = static_cast<int32_t>(int64Val);
-                        return;
-                    }
-                    out = int64Val;
-                    return;
-                }
+            m_stack.back().key = "~";
+            return;
+        }
+        if (MappingNode* node = Begin(false, anchor))
+            Remember(anchor, *node);
+    }
 
-                else
-                {
-                    uint64_t uint64Val = std::stoull(content);
-
-                    if (uint64Val <= std::numeric_limits<uint32_t>::max())
-                    {
-                        out = static_cast<uint32_t>(uint64Val);
-                        return;
-                    }
-                    out = uint64Val;
-                    return;
-                }
-            }
-            catch (const std::out_of_range&) { throw std::runtime_error("Bad integral parsing."); }
+    void OnAlias(const YAML::Mark&, const YAML::anchor_t anchor) override
+    {
+        auto it = m_anchors.find(anchor);
+        if (IsKey())
+        {
+            m_stack.back().key = (it != m_anchors.end() && it->second.IsString()) ? std::string(it->second.AsStringView()) : "";
+            return;
         }
+        if (MappingNode* node = Begin(false, YAML::NullAnchor, true))
+        {
+            if (it != m_anchors.end())
+                *node = it->second.Share();
+        }
+    }
+
+    void OnScalar(const YAML::Mark& mark, const std::string& tag, const YAML::anchor_t anchor, const std::string& value) override
+    {
+        if (IsKey())
+        {
+            m_stack.back().key = value;
+            return;
+        }
+        if (MappingNode* node = Begin(false, anchor))
+        {
+            ImportScalar(mark, tag, value, *node, m_arena);
+            Remember(anchor, *node);
+        }
+    }
 
-        // DECIMAL
-        double doubleVal = std::stod(content);
+    void OnSequenceStart(const YAML::Mark&, const std::string&, const YAML::anchor_t anchor, YAML::EmitterStyle::value) override
+    {
+        Open(false, anchor);
+    }
+
+    void OnSequenceEnd() override
+    {
+        Close();
+    }
+
+    void OnMapStart(const YAML::Mark&, const std::string&, const YAML::anchor_t anchor, YAML::EmitterStyle::value) override
+    {
+        Open(true, anchor);
+    }
 
-        float floatVal = static_cast<float>(doubleVal);
-        if (static_cast<double>(floatVal) == doubleVal)
+    void OnMapEnd() override
+    {
+        Close();
+    }
+
+private:
+    struct Frame
+    {
+        Frame(MappingNode* node, const bool isMap, const bool descend = false, const bool detached = false,
+            const YAML::anchor_t anchor = YAML::NullAnchor)
+            : node(node), isMap(isMap), descend(descend), detached(detached), anchor(anchor)
         {
-            out = floatVal;
+        }
+
+        MappingNode* node; // null while skipping
+        bool isMap;
+        bool descend = false; // children are offered to the walker one by one
+        bool detached = false; // built only for its anchor
+        YAML::anchor_t anchor = YAML::NullAnchor;
+        bool expectKey = true;
+        size_t count = 0; // source elements seen, when descending into a sequence
+        std::string key;
+    };
+
+    // Map events alternate key, value; true if this event is a key
+    bool IsKey()
+    {
+        if (m_stack.empty() || !m_stack.back().isMap)
+            return false;
+        Frame& frame = m_stack.back();
+        frame.expectKey = !frame.expectKey;
+        return !frame.expectKey;
+    }
+
+    // Where the value starting now goes, or null to skip it
+    MappingNode* Begin(const bool container, const YAML::anchor_t anchor, const bool alias = false)
+    {
+        m_descend = false;
+        m_detached = false;
+        Frame* parent = (m_stack.empty()) ? nullptr : &m_stack.back();
+
+        Projection::Decision decision = Projection::Decision::Keep;
+        if (parent && !parent->node)
+        {
+            decision = Projection::Decision::Skip;
+        }
+        else if (!parent)
+        {
+            decision = m_walker.Root();
+        }
+        else if (parent->descend)
+        {
+            decision = (parent->isMap) ? m_walker.Enter(parent->key) : m_walker.Enter(parent->count++);
+        }
+
+        if (decision == Projection::Decision::Descend && !container)
+        {
+            if (parent)
+                m_walker.Leave();
+            decision = (alias) ? Projection::Decision::Keep : Projection::Decision::Skip;
+        }
+
+        if (decision == Projection::Decision::Skip)
+        {
+            if (anchor == YAML::NullAnchor)
+                return nullptr;
+            m_detached = true;
+            MappingNode& detached = m_anchors[anchor];
+            detached.Clear();
+            return &detached;
+        }
+
+        m_descend = (decision == Projection::Decision::Descend);
+        return &Next();
+    }
+
+    MappingNode& Next()
+    {
+        if (m_stack.empty())
+            return m_root;
+
+        MappingNode& parent = *m_stack.back().node;
+        if (m_stack.back().isMap)
+        {
+            MappingNode& child = parent[m_stack.back().key];
+            child.Clear();
+            return child;
+        }
+        parent.PushBack(MappingNode());
+        return parent[parent.Size() - 1];
+    }
+
+    void Open(const bool isMap, const YAML::anchor_t anchor)
+    {
+        if (IsKey())
+        {
+            if (m_stack.back().node)
+                throw std::runtime_error("Mapping keys must be scalars");
+            m_stack.emplace_back(nullptr, isMap);
             return;
         }
-        out = doubleVal;
-        return;
+
+        MappingNode* node = Begin(true, anchor);
+        m_stack.emplace_back(node, isMap, m_descend, m_detached, anchor);
     }
 
-    // STRING
-    out = content;
+    void Close()
+    {
+        const Frame frame = std::move(m_stack.back());
+        m_stack.pop_back();
+        if (!frame.node || frame.detached)
+            return;
+
+        Remember(frame.anchor, *frame.node);
+        if (!frame.descend || m_stack.empty())
+            return;
+
+        m_walker.Leave();
+        if (!frame.node->IsDefined())
+        {
+            // Nothing under it was selected
+            MappingNode& parent = *m_stack.back().node;
+            if (parent.IsArray())
+                parent.Erase(parent.Size() - 1);
+            else
+                parent.Erase(m_stack.back().key);
+        }
+    }
+
+    void Remember(const YAML::anchor_t anchor, const MappingNode& node)
+    {
+        if (anchor != YAML::NullAnchor && &node != &m_anchors[anchor])
+            m_anchors[anchor] = node.Share();
+    }
+
+    MappingNode& m_root;
+    Projection::Walker m_walker;
+    std::shared_ptr<StringArena> m_arena;
+    std::vector<Frame> m_stack;
+    std::unordered_map<YAML::anchor_t, MappingNode> m_anchors;
+    bool m_descend = false;
+    bool m_detached = false;
+};
+}
+
+// Written as plain scalars; yaml-cpp's own conversion goes through a stringstream per value
+static std::string NumberText(const MappingNode& in)
+{
+    if (in.HasDecimal())
+    {
+        const double value = in.As<double>();
+        if (std::isnan(value))
+            return ".nan";
+        if (std::isinf(value))
+            return (value < 0) ? "-.inf" : ".inf";
+        // Floats widened, as in the JSON writer, so loading narrows them back to the same float
+        return NumberFormat::ToString(value);
+    }
+
+    if (in.IsNegative())
+        return NumberFormat::ToString(in.As<int64_t>());
+    return NumberFormat::ToString(in.As<uint64_t>());
+}
+
+// An element of a packed array, written as the node it unpacks to would be
+static std::string PackedText(const double value)
+{
+    if (MappingNode::StoresAsInteger(value))
+        return NumberFormat::ToString(static_cast<int64_t>(value));
+    return NumberFormat::ToString(value);
+}
+
+// yaml-cpp's emitter writes U+FFFD for a malformed sequence; this refuses the string instead
+static void CheckUtf8(const std::string_view text)
+{
+    if (!Utf8::IsValid(text))
+        throw std::runtime_error("Cannot save a string that is not valid UTF-8");
 }
 
-static void Export(YAML::Node& out, const MappingNode& in)
+static void Export(YAML::Node& out, const MappingNode& in, const bool checkUtf8)
 {
+    if (!in.IsDefined())
+    {
+        out = YAML::Null;
+        return;
+    }
+
     if (in.IsMapping())
     {
         for (const MappingNode& child : in)
         {
-            Export(out[child.Key()], child);
+            if (checkUtf8)
+                CheckUtf8(child.Key());
+            YAML::Node result = out[child.Key()];
+            Export(result, child, checkUtf8);
+        }
+        return;
+    }
+
+    if (in.IsPacked())
+    {
+        for (const double value : in.PackedValues())
+        {
+            out.push_back(PackedText(value));
         }
         return;
     }
@@ -141,7 +495,7 @@ static void Export(YAML::Node& out, const MappingNode& in)
         for (const MappingNode& child : in)
         {
             YAML::Node result;
-            Export(result, child);
+            Export(result, child, checkUtf8);
             out.push_back(result);
         }
         return;
@@ -153,63 +507,231 @@ static void Export(YAML::Node& out, const MappingNode& in)
         return;
     }
 
+    if (in.IsRawNumber())
+    {
+        out = std::string(in.RawNumber());
+        return;
+    }
+
     if (in.IsNumeric())
     {
-        if (in.HasDecimal())
+        out = NumberText(in);
+        return;
+    }
+
+    if (in.IsBinary())
+    {
+        // The node emitter writes the tag verbatim: !<tag:yaml.org,2002:binary>
+        const ByteSpan bytes = in.AsBytes();
+        out = Base64::Encode(bytes.data(), bytes.size());
+        out.SetTag(s_binaryTag);
+        return;
+    }
+
+    std::string text = in.As<std::string>();
+    if (checkUtf8)
+        CheckUtf8(text);
+    out = std::move(text);
+}
+
+// Read-only view of a file mapped into memory
+class MappedFile
+{
+public:
+    MappedFile(const std::filesystem::path& path)
+    {
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Could not open file: " + path.string());
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(m_file, &size);
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size == 0)
+            return;
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping)
+            m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        m_file = open(path.c_str(), O_RDONLY);
+        if (m_file < 0)
+            throw std::runtime_error("Could not open file: " + path.string());
+
+        struct stat info;
+        fstat(m_file, &info);
+        m_size = static_cast<size_t>(info.st_size);
+        if (m_size == 0)
+            return;
+
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+        if (data != MAP_FAILED)
         {
-            if (in.Width() == sizeof(float))
-            {
-                out = in.As<float>();
-                return;
-            }
-            out = in.As<double>();
-			return;
-		}
+            madvise(data, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(data);
+        }
+#endif
+        if (!m_data)
+        {
+            Close();
+            throw std::runtime_error("Could not map file: " + path.string());
+        }
+    }
+
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view View() const { return std::string_view(m_data, (m_data) ? m_size : 0); }
 
-		if (in.IsNegative())
-		{
-            if (in.Width() <= sizeof(int32_t))
+private:
+    void Close()
+    {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap(const_cast<char*>(m_data), m_size);
+        if (m_file >= 0) close(m_file);
+        m_file = -1;
+#endif
+        m_data = nullptr;
+    }
+
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Lets yaml-cpp read a document straight out of a memory range without copying it
+class MemoryBuffer : public std::streambuf
+{
+public:
+    MemoryBuffer(std::string_view content)
+    {
+        char* begin = const_cast<char*>(content.data());
+        setg(begin, begin, begin + content.size());
+    }
+};
+
+static bool IsMarker(std::string_view line, const char* marker)
+{
+    return line.size() >= 3 && line.compare(0, 3, marker) == 0 &&
+        (line.size() == 3 || line[3] == ' ' || line[3] == '\t' || line[3] == '\r' || line[3] == '\n');
+}
+
+// Splits a stream on '---' / '...' markers at column zero. Directives and comments
+// ahead of a '---' stay with the document they precede.
+static std::vector<std::string_view> SplitDocuments(std::string_view content)
+{
+    std::vector<std::string_view> result;
+    size_t docStart = 0;
+    bool hasContent = false;
+
+    size_t lineStart = 0;
+    while (lineStart < content.size())
+    {
+        size_t lineEnd = content.find('\n', lineStart);
+        lineEnd = (lineEnd == std::string_view::npos) ? content.size() : lineEnd + 1;
+        std::string_view line = content.substr(lineStart, lineEnd - lineStart);
+
+        if (IsMarker(line, "---"))
+        {
+            if (hasContent)
             {
-                out = in.As<int32_t>();
-                return;
+                result.push_back(content.substr(docStart, lineStart - docStart));
+                docStart = lineStart;
             }
-            out = in.As<int64_t>();
-            return;
+            hasContent = true;
         }
-
-        if (in.Width() <= sizeof(uint32_t))
+        else if (IsMarker(line, "..."))
         {
-            out = in.As<uint32_t>();
-            return;
+            if (hasContent)
+                result.push_back(content.substr(docStart, lineStart - docStart));
+            docStart = lineEnd;
+            hasContent = false;
         }
-        out = in.As<uint64_t>();
-        return;
+        else if (!hasContent)
+        {
+            size_t first = line.find_first_not_of(" \t\r\n");
+            hasContent = first != std::string_view::npos && line[first] != '#' && line[first] != '%';
+        }
+
+        lineStart = lineEnd;
+    }
+
+    if (hasContent)
+        result.push_back(content.substr(docStart));
+
+    return result;
+}
+
+// yaml-cpp takes malformed UTF-8 through as it is, so text is checked before it is parsed.
+// Text yaml-cpp reads as UTF-16 or UTF-32 (a byte-order mark or a zero byte up front) is left to it.
+static void CheckEncoding(const std::string_view content)
+{
+    if (content.size() >= 2)
+    {
+        const uint8_t first = static_cast<uint8_t>(content[0]);
+        const uint8_t second = static_cast<uint8_t>(content[1]);
+        if (first == 0 || second == 0 || (first == 0xFE && second == 0xFF) || (first == 0xFF && second == 0xFE))
+            return;
     }
+    if (Utf8::IsValid(content))
+        return;
 
-    out = in.As<std::string>();
+    ParseError error;
+    error.Locate(content, Utf8::FindInvalid(content.data(), content.size()));
+    YAML::Mark mark;
+    mark.pos = static_cast<int>(error.offset);
+    mark.line = static_cast<int>(error.line) - 1;
+    mark.column = static_cast<int>(error.column) - 1;
+    throw YAML::ParserException(mark, "invalid UTF-8");
+}
+
+static std::shared_ptr<StringArena> MakeArena(const bool borrowStrings)
+{
+    return (borrowStrings) ? std::make_shared<StringArena>() : nullptr;
+}
+
+static MappingNode LoadDocument(std::string_view document, const bool borrowStrings, const bool packNumbers)
+{
+    MemoryBuffer buffer(document);
+    std::istream stream(&buffer);
+
+    MappingNode result;
+    YAML::Node in = YAML::Load(stream);
+    Import(in, result, MakeArena(borrowStrings), packNumbers);
+    return result;
 }
 
 MappingNode xe::YAMLFormatter::LoadFile(const std::filesystem::path& path)
 {
-    std::ifstream file(path, std::ios::ate);
-    size_t length = file.tellg();
+    std::vector<uint8_t> content = FileIO::ReadFile(path);
 
-    if (length == 0)
+    if (content.empty())
         return MappingNode();
 
-    file.seekg(0, std::ios::beg);
-    std::vector<char> content(length + 1);
-    file.read(content.data(), length);
-    content.back() = '\0';
-    return LoadContent(content.data());
-    
+    return LoadContent(content.data(), content.size());
 }
 
 MappingNode xe::YAMLFormatter::LoadContent(const std::string& content)
 {
+    CheckEncoding(content);
+
     MappingNode result;
     YAML::Node in = YAML::Load(content);
-    Import(in, result);
+    Import(in, result, MakeArena(m_borrowStrings), m_packNumericArrays);
     return result;
 }
 
@@ -223,22 +745,68 @@ MappingNode xe::YAMLFormatter::LoadContent(const std::vector<uint8_t>& content)
     return LoadContent((const char*)content.data());
 }
 
+MappingNode xe::YAMLFormatter::LoadContent(const uint8_t* data, size_t size)
+{
+    std::string_view content((const char*)data, size);
+    CheckEncoding(content);
+    return LoadDocument(content, m_borrowStrings, m_packNumericArrays);
+}
+
+MappingNode xe::YAMLFormatter::LoadContent(const uint8_t* data, size_t size, const Projection& projection)
+{
+    std::string_view content((const char*)data, size);
+    CheckEncoding(content);
+
+    MemoryBuffer buffer(content);
+    std::istream stream(&buffer);
+
+    MappingNode result;
+    ProjectedImporter importer(result, projection, MakeArena(m_borrowStrings));
+    YAML::Parser parser(stream);
+    parser.HandleNextDocument(importer);
+    return result;
+}
+
+// yaml-cpp only reports errors by throwing, so this catches; the mark gives the position
+ParseResult xe::YAMLFormatter::TryLoadContent(const uint8_t* data, size_t size)
+{
+    ParseResult result;
+    try
+    {
+        result.node = LoadContent(data, size);
+    }
+    catch (const YAML::Exception& e)
+    {
+        result.node.Clear();
+        result.error.code = ParseError::Code::Syntax;
+        result.error.message = e.msg;
+        if (!e.mark.is_null())
+        {
+            result.error.offset = static_cast<size_t>(e.mark.pos);
+            result.error.line = static_cast<size_t>(e.mark.line) + 1;
+            result.error.column = static_cast<size_t>(e.mark.column) + 1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        result.node.Clear();
+        result.error.code = ParseError::Code::Other;
+        result.error.message = e.what();
+    }
+    return result;
+}
+
 bool xe::YAMLFormatter::SaveFile(const MappingNode& node, const std::filesystem::path& path)
 {
     std::string content;
     SaveContent(node, content);
-    std::ofstream file(path);
-    if (!file.is_open())
-        return false;
-
-    file << content;
-    return true;
+    return FileIO::WriteFile(path, content.data(), content.length());
 }
 
 void xe::YAMLFormatter::SaveContent(const MappingNode& node, std::string& out_content)
 {
     YAML::Node out;
-    Export(out, node);
+    Export(out, node, m_checkUtf8OnSave);
     std::stringstream stream;
     stream << out;
     out_content = stream.str();
@@ -250,6 +818,65 @@ void xe::YAMLFormatter::SaveContent(const MappingNode& node, std::vector<uint8_t
     SaveContent(node, contentStr);
     out_content.clear();
     out_content.resize(contentStr.length() + 1);
-    memcpy_s(out_content.data(), contentStr.length(), contentStr.c_str(), contentStr.length());
+    std::memcpy(out_content.data(), contentStr.c_str(), contentStr.length());
     out_content.back() = 0;
 }
+
+
+std::vector<MappingNode> xe::YAMLFormatter::LoadAllFile(const std::filesystem::path& path, size_t threadCount)
+{
+    MappedFile file(path);
+    return LoadAllContent(file.View(), threadCount);
+}
+
+std::vector<MappingNode> xe::YAMLFormatter::LoadAllContent(std::string_view content, size_t threadCount)
+{
+    CheckEncoding(content);
+    std::vector<std::string_view> documents = SplitDocuments(content);
+    std::vector<MappingNode> result(documents.size());
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, documents.size());
+
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < documents.size(); ++i)
+            result[i] = LoadDocument(documents[i], m_borrowStrings, m_packNumericArrays);
+        return result;
+    }
+
+    std::vector<std::exception_ptr> errors(documents.size());
+    std::atomic<size_t> next = 0;
+    auto worker = [&]()
+        {
+            for (size_t i = next++; i < documents.size(); i = next++)
+            {
+                try
+                {
+                    result[i] = LoadDocument(documents[i], m_borrowStrings, m_packNumericArrays);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // Report the first failing document in stream order
+    for (const std::exception_ptr& error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    return result;
+}
\ No newline at end of file
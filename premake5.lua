@@ -171,6 +171,45 @@ project "XEMarkup-BSON"
 
     libdirs "%{prj.name}/lib"
 
+    filter "system:windows"
+        systemversion "latest"
+        defines { "WIN32" }
+
+    filter "configurations:Debug"
+        defines { "_DEBUG", "_CONSOLE" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG", "_CONSOLE" }
+        optimize "On"
+
+project "Benchmark"
+    location "%{prj.name}"
+    kind "ConsoleApp"
+    language "C++"
+    targetname "%{prj.name}"
+    targetdir ("bin/".. outputdir)
+    objdir ("%{prj.name}/int/" .. outputdir)
+    cppdialect "C++17"
+    staticruntime "Off"
+
+    files
+    {
+        "%{prj.name}/**.h",
+        "%{prj.name}/**.cpp"
+    }
+
+    includedirs
+    {
+        "XEMarkup-Common/include",
+        "XEMarkup-JSON/include"
+    }
+
+    links
+    {
+        "XEMarkup-JSON"
+    }
+
     filter "system:windows"
         systemversion "latest"
         defines { "WIN32" }